@@ -0,0 +1,136 @@
+//-----------------------------------------------------------------------------
+// Bump allocator arena. Everything allocated from it is released at once.
+// Use "#define HH_ARENA_IMPLEMENTATION" ones in your .c file to
+// implement the functions of the library
+//-----------------------------------------------------------------------------
+// Author		: github.com/SMDHuman
+// Last Update	: 17.10.2026
+//-----------------------------------------------------------------------------
+#ifndef HH_ARENA_BLOCK_SIZE
+#define HH_ARENA_BLOCK_SIZE (1 << 20) // Default block size in bytes
+#endif
+#ifndef HH_ARENA_ALIGN
+#define HH_ARENA_ALIGN 16 // Alignment of every allocation, power of two
+#endif
+
+// If defined, all function names start with har_*, else hh_arena_*
+//#define HH_ARENA_SHORT_PREFIX
+
+#ifndef HH_ARENA_H
+#define HH_ARENA_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+typedef struct hh_arena_block_t{
+	struct hh_arena_block_t *next; // Previously filled block
+	size_t size; // How much of it available in bytes
+	size_t fill; // How much of it used in bytes
+}hh_arena_block_t;
+
+typedef struct hh_arena_t{
+	hh_arena_block_t *block; // Block currently allocated from
+	size_t block_size; // Size of newly created blocks
+	void *last; // Last allocation, the only one that can grow in place
+}hh_arena_t;
+
+#ifdef HH_ARENA_SHORT_PREFIX
+#define har_init hh_arena_init
+#define har_deinit hh_arena_deinit
+#define har_alloc hh_arena_alloc
+#define har_realloc hh_arena_realloc
+#define har_free hh_arena_free
+#define har_reset hh_arena_reset
+#endif
+
+// Initialize the arena, block_size 0 means HH_ARENA_BLOCK_SIZE
+void hh_arena_init(hh_arena_t* arena, size_t block_size);
+// Release every block of the arena
+void hh_arena_deinit(hh_arena_t* arena);
+// Allocate size bytes from the arena
+void* hh_arena_alloc(hh_arena_t* arena, size_t size);
+// Grow or shrink an allocation. Takes the arena as void* so it can be used
+// as an allocator hook, e.g. for hh_darray_allocator_t
+void* hh_arena_realloc(void* arena, void* ptr, size_t old_size, size_t new_size);
+// Does nothing, memory is given back by hh_arena_reset or hh_arena_deinit
+void hh_arena_free(void* arena, void* ptr);
+// Forget all allocations but keep the newest block for reuse
+void hh_arena_reset(hh_arena_t* arena);
+
+//-----------------------------------------------------------------------------
+// hh_arena function implementations
+	#ifdef HH_ARENA_IMPLEMENTATION
+
+	#define HH_ARENA_ROUND(n) (((n) + HH_ARENA_ALIGN - 1) & ~(size_t)(HH_ARENA_ALIGN - 1))
+	#define HH_ARENA_HEADER HH_ARENA_ROUND(sizeof(hh_arena_block_t))
+
+	void hh_arena_init(hh_arena_t* arena, size_t block_size){
+		arena->block = 0;
+		arena->block_size = block_size ? block_size : HH_ARENA_BLOCK_SIZE;
+		arena->last = 0;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_arena_deinit(hh_arena_t* arena){
+		while(arena->block){
+			hh_arena_block_t *next = arena->block->next;
+			free(arena->block);
+			arena->block = next;
+		}
+		arena->last = 0;
+	}
+	//-----------------------------------------------------------------------------
+	void* hh_arena_alloc(hh_arena_t* arena, size_t size){
+		size = HH_ARENA_ROUND(size);
+		hh_arena_block_t *block = arena->block;
+		if(!block || block->fill + size > block->size){
+			// Oversized requests get a block of their own
+			size_t block_size = size > arena->block_size ? size : arena->block_size;
+			block = malloc(HH_ARENA_HEADER + block_size);
+			if(!block) return 0;
+			block->size = block_size;
+			block->fill = 0;
+			block->next = arena->block;
+			arena->block = block;
+		}
+		void *ptr = (char*)block + HH_ARENA_HEADER + block->fill;
+		block->fill += size;
+		arena->last = ptr;
+		return ptr;
+	}
+	//-----------------------------------------------------------------------------
+	void* hh_arena_realloc(void* context, void* ptr, size_t old_size, size_t new_size){
+		hh_arena_t *arena = context;
+		if(!ptr) return hh_arena_alloc(arena, new_size);
+		if(ptr == arena->last){
+			hh_arena_block_t *block = arena->block;
+			size_t offset = (size_t)((char*)ptr - ((char*)block + HH_ARENA_HEADER));
+			if(offset + HH_ARENA_ROUND(new_size) <= block->size){
+				block->fill = offset + HH_ARENA_ROUND(new_size);
+				return ptr;
+			}
+		}
+		if(new_size <= old_size) return ptr;
+		void *new_ptr = hh_arena_alloc(arena, new_size);
+		if(new_ptr) memcpy(new_ptr, ptr, old_size);
+		return new_ptr;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_arena_free(void* arena, void* ptr){
+		(void)arena;
+		(void)ptr;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_arena_reset(hh_arena_t* arena){
+		if(!arena->block) return;
+		hh_arena_block_t *keep = arena->block;
+		arena->block = keep->next;
+		hh_arena_deinit(arena);
+		keep->next = 0;
+		keep->fill = 0;
+		arena->block = keep;
+	}
+
+	#endif
+#endif
@@ -0,0 +1,250 @@
+//-----------------------------------------------------------------------------
+// Bitset and 2D bitmap library, one bit per element packed in 64 bit words
+// Use "#define HH_BITSET_IMPLEMENTATION" ones in your .c file to
+// implement the functions of the library
+//-----------------------------------------------------------------------------
+// Author		: github.com/SMDHuman
+// Last Update	: 17.10.2026
+//-----------------------------------------------------------------------------
+// If defined, all function names start with hbs_*/hbm_*, else hh_bitset_*/hh_bitmap_*
+//#define HH_BITSET_SHORT_PREFIX
+
+#ifndef HH_BITSET_H
+#define HH_BITSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// How many 64 bit words are needed for given bit count
+#define HH_BITSET_WORDS(bits) (((bits) + 63) >> 6)
+
+//-----------------------------------------------------------------------------
+typedef struct hh_bitset_t{
+	size_t bits; // How many bits it holds
+	size_t words; // How many words the bits take
+	uint64_t *data; // Word buffer location, bits past the end are kept zero
+}hh_bitset_t;
+
+typedef struct hh_bitmap_t{
+	size_t width, height; // Size in bits
+	size_t stride; // Words per row
+	uint64_t *data; // Word buffer location, rows are word aligned
+}hh_bitmap_t;
+
+#ifdef HH_BITSET_SHORT_PREFIX
+#define hbs_init hh_bitset_init
+#define hbs_deinit hh_bitset_deinit
+#define hbs_resize hh_bitset_resize
+#define hbs_test hh_bitset_test
+#define hbs_set hh_bitset_set
+#define hbs_clear hh_bitset_clear
+#define hbs_toggle hh_bitset_toggle
+#define hbs_assign hh_bitset_assign
+#define hbs_set_all hh_bitset_set_all
+#define hbs_clear_all hh_bitset_clear_all
+#define hbs_copy hh_bitset_copy
+#define hbs_popcount hh_bitset_popcount
+#define hbs_find_next_set hh_bitset_find_next_set
+#define hbs_and hh_bitset_and
+#define hbs_or hh_bitset_or
+#define hbs_xor hh_bitset_xor
+#define hbs_andnot hh_bitset_andnot
+#define hbm_init hh_bitmap_init
+#define hbm_deinit hh_bitmap_deinit
+#define hbm_test hh_bitmap_test
+#define hbm_set hh_bitmap_set
+#define hbm_clear hh_bitmap_clear
+#define hbm_clear_all hh_bitmap_clear_all
+#endif
+
+// Initialize the bitset with all bits cleared
+void hh_bitset_init(hh_bitset_t* set, size_t bits);
+// Deinitialize the bitset
+void hh_bitset_deinit(hh_bitset_t* set);
+// Change the bit count, kept bits stay as they are and new ones are cleared
+void hh_bitset_resize(hh_bitset_t* set, size_t bits);
+// Set every bit
+void hh_bitset_set_all(hh_bitset_t* set);
+// Clear every bit
+void hh_bitset_clear_all(hh_bitset_t* set);
+// Copy source into set, bit counts must match
+void hh_bitset_copy(hh_bitset_t* set, hh_bitset_t* source);
+// Count the set bits
+size_t hh_bitset_popcount(hh_bitset_t* set);
+// Index of the first set bit at or after from, (size_t)-1 if there is none
+size_t hh_bitset_find_next_set(hh_bitset_t* set, size_t from);
+// set = a & b, bit counts must match
+void hh_bitset_and(hh_bitset_t* set, hh_bitset_t* a, hh_bitset_t* b);
+// set = a | b, bit counts must match
+void hh_bitset_or(hh_bitset_t* set, hh_bitset_t* a, hh_bitset_t* b);
+// set = a ^ b, bit counts must match
+void hh_bitset_xor(hh_bitset_t* set, hh_bitset_t* a, hh_bitset_t* b);
+// set = a & ~b, bit counts must match
+void hh_bitset_andnot(hh_bitset_t* set, hh_bitset_t* a, hh_bitset_t* b);
+// Initialize the bitmap with all bits cleared
+void hh_bitmap_init(hh_bitmap_t* map, size_t width, size_t height);
+// Deinitialize the bitmap
+void hh_bitmap_deinit(hh_bitmap_t* map);
+// Clear every bit
+void hh_bitmap_clear_all(hh_bitmap_t* map);
+
+//-----------------------------------------------------------------------------
+// Single bit access, not bounds checked
+static inline int hh_bitset_test(hh_bitset_t* set, size_t index){
+	return (set->data[index >> 6] >> (index & 63)) & 1;
+}
+static inline void hh_bitset_set(hh_bitset_t* set, size_t index){
+	set->data[index >> 6] |= (uint64_t)1 << (index & 63);
+}
+static inline void hh_bitset_clear(hh_bitset_t* set, size_t index){
+	set->data[index >> 6] &= ~((uint64_t)1 << (index & 63));
+}
+static inline void hh_bitset_toggle(hh_bitset_t* set, size_t index){
+	set->data[index >> 6] ^= (uint64_t)1 << (index & 63);
+}
+static inline void hh_bitset_assign(hh_bitset_t* set, size_t index, int value){
+	uint64_t mask = (uint64_t)1 << (index & 63);
+	set->data[index >> 6] = (set->data[index >> 6] & ~mask) | (-(uint64_t)(value != 0) & mask);
+}
+// Bitmap access, coordinates outside of the map read as 0 and are not written
+static inline int hh_bitmap_test(hh_bitmap_t* map, size_t x, size_t y){
+	if(x >= map->width || y >= map->height) return 0;
+	return (map->data[y*map->stride + (x >> 6)] >> (x & 63)) & 1;
+}
+static inline void hh_bitmap_set(hh_bitmap_t* map, size_t x, size_t y){
+	if(x >= map->width || y >= map->height) return;
+	map->data[y*map->stride + (x >> 6)] |= (uint64_t)1 << (x & 63);
+}
+static inline void hh_bitmap_clear(hh_bitmap_t* map, size_t x, size_t y){
+	if(x >= map->width || y >= map->height) return;
+	map->data[y*map->stride + (x >> 6)] &= ~((uint64_t)1 << (x & 63));
+}
+static inline int hh_bitset_word_popcount(uint64_t word){
+	#if defined(__GNUC__)
+	return __builtin_popcountll(word);
+	#else
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((word * 0x0101010101010101ULL) >> 56);
+	#endif
+}
+static inline int hh_bitset_word_ctz(uint64_t word){
+	#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+	#else
+	int n = 0;
+	while(!(word & 1)){ word >>= 1; n++; }
+	return n;
+	#endif
+}
+
+//-----------------------------------------------------------------------------
+// hh_bitset function implementations
+	#ifdef HH_BITSET_IMPLEMENTATION
+
+	void hh_bitset_init(hh_bitset_t* set, size_t bits){
+		set->bits = bits;
+		set->words = HH_BITSET_WORDS(bits);
+		set->data = calloc(set->words ? set->words : 1, sizeof(uint64_t));
+	}
+	//-----------------------------------------------------------------------------
+	void hh_bitset_deinit(hh_bitset_t* set){
+		free(set->data);
+		memset(set, 0, sizeof(hh_bitset_t));
+	}
+	//-----------------------------------------------------------------------------
+	// Clears the unused bits of the last word
+	static void hh_bitset_trim(hh_bitset_t* set){
+		if(set->bits & 63) set->data[set->words - 1] &= ((uint64_t)1 << (set->bits & 63)) - 1;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_bitset_resize(hh_bitset_t* set, size_t bits){
+		size_t words = HH_BITSET_WORDS(bits);
+		if(words != set->words){
+			set->data = realloc(set->data, (words ? words : 1) * sizeof(uint64_t));
+			if(words > set->words) memset(set->data + set->words, 0, (words - set->words) * sizeof(uint64_t));
+			set->words = words;
+		}
+		set->bits = bits;
+		if(set->words) hh_bitset_trim(set);
+	}
+	//-----------------------------------------------------------------------------
+	void hh_bitset_set_all(hh_bitset_t* set){
+		if(!set->words) return;
+		memset(set->data, 0xFF, set->words * sizeof(uint64_t));
+		hh_bitset_trim(set);
+	}
+	//-----------------------------------------------------------------------------
+	void hh_bitset_clear_all(hh_bitset_t* set){
+		memset(set->data, 0, set->words * sizeof(uint64_t));
+	}
+	//-----------------------------------------------------------------------------
+	void hh_bitset_copy(hh_bitset_t* set, hh_bitset_t* source){
+		memcpy(set->data, source->data, set->words * sizeof(uint64_t));
+	}
+	//-----------------------------------------------------------------------------
+	size_t hh_bitset_popcount(hh_bitset_t* set){
+		size_t count = 0;
+		for(size_t i = 0; i < set->words; i++) count += hh_bitset_word_popcount(set->data[i]);
+		return count;
+	}
+	//-----------------------------------------------------------------------------
+	size_t hh_bitset_find_next_set(hh_bitset_t* set, size_t from){
+		if(from >= set->bits) return -1;
+		size_t w = from >> 6;
+		uint64_t word = set->data[w] & (~(uint64_t)0 << (from & 63));
+		while(!word){
+			if(++w >= set->words) return -1;
+			word = set->data[w];
+		}
+		return (w << 6) + hh_bitset_word_ctz(word);
+	}
+	//-----------------------------------------------------------------------------
+	// Bulk operations, two words per step with SSE2 and the rest one by one
+	#if defined(__SSE2__)
+	#define HH_BITSET_BULK(name, simd_op, op) \
+		void name(hh_bitset_t* set, hh_bitset_t* a, hh_bitset_t* b){ \
+			size_t i = 0; \
+			for(; i + 2 <= set->words; i += 2){ \
+				__m128i va = _mm_loadu_si128((__m128i*)(a->data + i)); \
+				__m128i vb = _mm_loadu_si128((__m128i*)(b->data + i)); \
+				_mm_storeu_si128((__m128i*)(set->data + i), simd_op); \
+			} \
+			for(; i < set->words; i++) set->data[i] = op; \
+		}
+	#else
+	#define HH_BITSET_BULK(name, simd_op, op) \
+		void name(hh_bitset_t* set, hh_bitset_t* a, hh_bitset_t* b){ \
+			for(size_t i = 0; i < set->words; i++) set->data[i] = op; \
+		}
+	#endif
+	HH_BITSET_BULK(hh_bitset_and, _mm_and_si128(va, vb), a->data[i] & b->data[i])
+	HH_BITSET_BULK(hh_bitset_or, _mm_or_si128(va, vb), a->data[i] | b->data[i])
+	HH_BITSET_BULK(hh_bitset_xor, _mm_xor_si128(va, vb), a->data[i] ^ b->data[i])
+	HH_BITSET_BULK(hh_bitset_andnot, _mm_andnot_si128(vb, va), a->data[i] & ~b->data[i])
+	//-----------------------------------------------------------------------------
+	void hh_bitmap_init(hh_bitmap_t* map, size_t width, size_t height){
+		map->width = width;
+		map->height = height;
+		map->stride = HH_BITSET_WORDS(width);
+		size_t words = map->stride * height;
+		map->data = calloc(words ? words : 1, sizeof(uint64_t));
+	}
+	//-----------------------------------------------------------------------------
+	void hh_bitmap_deinit(hh_bitmap_t* map){
+		free(map->data);
+		memset(map, 0, sizeof(hh_bitmap_t));
+	}
+	//-----------------------------------------------------------------------------
+	void hh_bitmap_clear_all(hh_bitmap_t* map){
+		memset(map->data, 0, map->stride * map->height * sizeof(uint64_t));
+	}
+
+	#endif
+#endif
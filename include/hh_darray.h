@@ -4,7 +4,7 @@
 // implement the functions of the library
 //-----------------------------------------------------------------------------
 // Author		: github.com/SMDHuman
-// Last Update	: 14.11.2025
+// Last Update	: 17.10.2026
 //-----------------------------------------------------------------------------
 #ifndef HH_DARRAY_INIT_SIZE
 #define HH_DARRAY_INIT_SIZE 16
@@ -13,24 +13,89 @@
 // If defined, all function names start with hda_*, else hh_darray_*
 //#defien HH_DARRAY_SORT_PREFIX
 
+// If defined, arrays grow by reallocating one contiguous buffer instead of
+// chaining new segments. Indexing and item count become O(1), but references
+// returned by the library are invalidated when the array grows.
+//#define HH_DARRAY_CONTIGUOUS
+
+// If defined, arrays count their memory use and O(n) operations into a
+// hh_darray_stats_t record, shared by every array given the same record
+//#define HH_DARRAY_STATS
+
+// Default allocation functions, used by arrays without an allocator
+#ifndef HH_DARRAY_MALLOC
+#define HH_DARRAY_MALLOC malloc
+#endif
+#ifndef HH_DARRAY_REALLOC
+#define HH_DARRAY_REALLOC realloc
+#endif
+#ifndef HH_DARRAY_FREE
+#define HH_DARRAY_FREE free
+#endif
+
 #ifndef HH_DARRAY_H
 #define HH_DARRAY_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 //-----------------------------------------------------------------------------
+// Per array allocator. realloc gets ptr 0 for fresh allocations.
+typedef struct hh_darray_allocator_t{
+	void* (*realloc)(void* context, void* ptr, size_t old_size, size_t new_size);
+	void (*free)(void* context, void* ptr);
+	void *context;
+}hh_darray_allocator_t;
+
+#ifdef HH_DARRAY_STATS
+typedef struct hh_darray_stats_t{
+	const char *tag; // Name shown in the dump
+	size_t live_bytes; // Bytes currently allocated
+	size_t peak_bytes; // Highest live_bytes seen
+	size_t allocations; // Number of allocations and reallocations
+	size_t segments; // Chained segments currently alive
+	size_t linear_ops; // Number of O(n) push/pop/is_inside calls
+}hh_darray_stats_t;
+
+// Record of arrays that were not given one
+extern hh_darray_stats_t hh_darray_untagged_stats;
+#endif
+
 typedef struct hh_darray_t{
 	size_t size; // How much of it available in bytes
 	size_t fill; // How much of it used in bytes
 	size_t word; // Word size in bytes
+	size_t count; // How many items it holds (cached)
 	struct hh_darray_t *next; // Next darray for expention
 	void *data; // Data buffer location 	
+	hh_darray_allocator_t *allocator; // 0 for HH_DARRAY_MALLOC/FREE
+	#ifdef HH_DARRAY_STATS
+	hh_darray_stats_t *stats; // Record it counts into
+	#endif
 }hh_darray_t;
 
+//-----------------------------------------------------------------------------
+// Set of arrays for appending from many threads without locks. Every thread
+// appends to its own shard, read with the usual API, and the shards are
+// merged in index order once the threads are done.
+typedef struct hh_darray_shard_t{
+	_Alignas(64) hh_darray_t array; // Every shard on its own cache lines
+	#ifdef HH_DARRAY_STATS
+	hh_darray_stats_t stats; // Own record, shared ones are not thread safe
+	#endif
+}hh_darray_shard_t;
+
+typedef struct hh_darray_shards_t{
+	size_t count; // How many shards there are
+	hh_darray_shard_t *shards; // Shards, aligned inside buffer
+	void *buffer; // Allocated buffer location
+}hh_darray_shards_t;
+
 #ifdef HH_DARRAY_SHORT_PREFIX
 #define hda_init hh_darray_init
+#define hda_init_with hh_darray_init_with
 #define hda_deinit hh_darray_deinit
 #define hda_append hh_darray_append
 #define hda_append_no_dupe hh_darray_append_no_dupe
@@ -47,10 +112,22 @@ typedef struct hh_darray_t{
 #define hda_get_end_reference hh_darray_get_end_reference
 #define hda_remove_reference hh_darray_remove_reference
 #define hda_clear hh_darray_clear
+#define hda_reserve hh_darray_reserve
+#define hda_append_n hh_darray_append_n
+#define hda_extend_from hh_darray_extend_from
+#define hda_to_contiguous hh_darray_to_contiguous
+#define hda_shards_init hh_darray_shards_init
+#define hda_shards_deinit hh_darray_shards_deinit
+#define hda_shards_get hh_darray_shards_get
+#define hda_shards_merge hh_darray_shards_merge
+#define hda_set_stats hh_darray_set_stats
+#define hda_dump_stats hh_darray_dump_stats
 #endif
 
 // Initialize the array
 void hh_darray_init(hh_darray_t* array, size_t word); 
+// Initialize the array to take its memory from the allocator
+void hh_darray_init_with(hh_darray_t* array, size_t word, hh_darray_allocator_t* allocator); 
 // Deinitialize the array
 void hh_darray_deinit(hh_darray_t* array); 
 // Add the item to end of the array
@@ -83,38 +160,185 @@ void* hh_darray_get_end_reference(hh_darray_t* array);
 void hh_darray_remove_reference(hh_darray_t* array, void* reference);
 // Remove all elements
 void hh_darray_clear(hh_darray_t* array);
+// Make room for at least given item count in total without further growth
+void hh_darray_reserve(hh_darray_t* array, size_t items);
+// Add n items to end of the array, items 0 appends zeroed items
+void hh_darray_append_n(hh_darray_t* array, void* items, size_t n);
+// Add every item of source to end of the array, word sizes must match
+void hh_darray_extend_from(hh_darray_t* array, hh_darray_t* source);
+// Merge the chained segments into one buffer and return its location
+void* hh_darray_to_contiguous(hh_darray_t* array);
+// Initialize count shards with given word size
+void hh_darray_shards_init(hh_darray_shards_t* shards, size_t word, size_t count);
+// Deinitialize every shard
+void hh_darray_shards_deinit(hh_darray_shards_t* shards);
+// Returns the shard with index, one per thread
+hh_darray_t* hh_darray_shards_get(hh_darray_shards_t* shards, size_t index);
+// Add the items of every shard to end of the array in shard order
+void hh_darray_shards_merge(hh_darray_shards_t* shards, hh_darray_t* array);
+#ifdef HH_DARRAY_STATS
+#include <stdio.h>
+// Make the array count into given record, moving what it already counted
+void hh_darray_set_stats(hh_darray_t* array, hh_darray_stats_t* stats);
+// Print the record as one line
+void hh_darray_dump_stats(hh_darray_stats_t* stats, FILE* file);
+#endif
+
+//-----------------------------------------------------------------------------
+// Typed accessors with compile time item size, generated per element type.
+// HH_DARRAY_DEFINE(gate_t, gates) defines gates_init, gates_init_with,
+// gates_push, gates_get, gates_ref, gates_end and gates_count working on a
+// plain hh_darray_t.
+// Indexing is not bounds checked in HH_DARRAY_CONTIGUOUS mode.
+#ifdef HH_DARRAY_CONTIGUOUS
+#define HH_DARRAY_DEFINE(type, name) \
+	static inline void name##_init(hh_darray_t* array){ \
+		hh_darray_init(array, sizeof(type)); \
+	} \
+	static inline void name##_init_with(hh_darray_t* array, hh_darray_allocator_t* allocator){ \
+		hh_darray_init_with(array, sizeof(type), allocator); \
+	} \
+	static inline void name##_push(hh_darray_t* array, type item){ \
+		if(array->fill + sizeof(type) > array->size){ \
+			hh_darray_append(array, &item); \
+			return; \
+		} \
+		((type*)array->data)[array->count++] = item; \
+		array->fill += sizeof(type); \
+	} \
+	static inline type name##_get(hh_darray_t* array, size_t index){ \
+		return ((type*)array->data)[index]; \
+	} \
+	static inline type* name##_ref(hh_darray_t* array, size_t index){ \
+		return (type*)array->data + index; \
+	} \
+	static inline type* name##_end(hh_darray_t* array){ \
+		return (type*)array->data + (array->count - 1); \
+	} \
+	static inline size_t name##_count(hh_darray_t* array){ \
+		return array->count; \
+	}
+#else
+#define HH_DARRAY_DEFINE(type, name) \
+	static inline void name##_init(hh_darray_t* array){ \
+		hh_darray_init(array, sizeof(type)); \
+	} \
+	static inline void name##_init_with(hh_darray_t* array, hh_darray_allocator_t* allocator){ \
+		hh_darray_init_with(array, sizeof(type), allocator); \
+	} \
+	static inline void name##_push(hh_darray_t* array, type item){ \
+		hh_darray_append(array, &item); \
+	} \
+	static inline type name##_get(hh_darray_t* array, size_t index){ \
+		return *(type*)hh_darray_get_reference(array, index); \
+	} \
+	static inline type* name##_ref(hh_darray_t* array, size_t index){ \
+		return (type*)hh_darray_get_reference(array, index); \
+	} \
+	static inline type* name##_end(hh_darray_t* array){ \
+		return (type*)hh_darray_get_end_reference(array); \
+	} \
+	static inline size_t name##_count(hh_darray_t* array){ \
+		return hh_darray_get_item_fill(array); \
+	}
+#endif
 
 
 //-----------------------------------------------------------------------------
 // hh_darray function implementations
 	#ifdef HH_DARRAY_IMPLEMENTATION
 	
+	#ifdef HH_DARRAY_STATS
+	hh_darray_stats_t hh_darray_untagged_stats = {.tag = "untagged"};
+	#endif
+	//-----------------------------------------------------------------------------
+	static void* hh_darray_mem_realloc(hh_darray_t* array, void* ptr, size_t old_size, size_t new_size){
+		#ifdef HH_DARRAY_STATS
+		array->stats->allocations++;
+		array->stats->live_bytes += new_size - old_size;
+		if(array->stats->live_bytes > array->stats->peak_bytes) array->stats->peak_bytes = array->stats->live_bytes;
+		#endif
+		if(array->allocator) return array->allocator->realloc(array->allocator->context, ptr, old_size, new_size);
+		if(!ptr) return HH_DARRAY_MALLOC(new_size);
+		return HH_DARRAY_REALLOC(ptr, new_size);
+	}
+	//-----------------------------------------------------------------------------
+	static void hh_darray_mem_free(hh_darray_t* array, void* ptr, size_t size){
+		#ifdef HH_DARRAY_STATS
+		array->stats->live_bytes -= size;
+		#else
+		(void)size;
+		#endif
+		if(array->allocator){
+			if(array->allocator->free) array->allocator->free(array->allocator->context, ptr);
+		}
+		else HH_DARRAY_FREE(ptr);
+	}
+	//-----------------------------------------------------------------------------
+	#ifndef HH_DARRAY_CONTIGUOUS
+	// Chain a new empty segment of size bytes after last
+	static hh_darray_t* hh_darray_add_segment(hh_darray_t* array, hh_darray_t* last, size_t size){
+		last->next = hh_darray_mem_realloc(array, 0, 0, sizeof(hh_darray_t));
+		last->next->size = size;
+		last->next->fill = 0;
+		last->next->word = array->word;
+		last->next->count = 0;
+		last->next->next = 0;
+		last->next->allocator = array->allocator;
+		#ifdef HH_DARRAY_STATS
+		last->next->stats = array->stats;
+		array->stats->segments++;
+		#endif
+		last->next->data = hh_darray_mem_realloc(array, 0, 0, size);
+		return last->next;
+	}
+	#endif
+	//-----------------------------------------------------------------------------
 	void hh_darray_init(hh_darray_t* array, size_t word){
+		hh_darray_init_with(array, word, 0);
+	}
+	//-----------------------------------------------------------------------------
+	void hh_darray_init_with(hh_darray_t* array, size_t word, hh_darray_allocator_t* allocator){
 		array->size = word*HH_DARRAY_INIT_SIZE;
 		array->fill = 0;
 		array->word = word;
+		array->count = 0;
 		array->next = 0;
-		array->data = malloc(array->size);
+		array->allocator = allocator;
+		#ifdef HH_DARRAY_STATS
+		array->stats = &hh_darray_untagged_stats;
+		#endif
+		array->data = hh_darray_mem_realloc(array, 0, 0, array->size);
 	}
 	//-----------------------------------------------------------------------------
 	void hh_darray_deinit(hh_darray_t* array){
 		if(array->next){
 			hh_darray_deinit(array->next);
-			free(array->next);
+			hh_darray_mem_free(array, array->next, sizeof(hh_darray_t));
+			#ifdef HH_DARRAY_STATS
+			array->stats->segments--;
+			#endif
 		}
-		free(array->data);
+		hh_darray_mem_free(array, array->data, array->size);
 		memset(array, 0, sizeof(hh_darray_t));
 	}
 	//-----------------------------------------------------------------------------
 	void hh_darray_append(hh_darray_t* array, void* item){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(array->fill + array->word > array->size){
+			size_t old_size = array->size;
+			array->size = (array->size << 1) - (array->size >> 1);
+			if(array->size < array->fill + array->word) array->size = array->fill + array->word;
+			array->data = hh_darray_mem_realloc(array, array->data, old_size, array->size);
+		}
+		if(item) memcpy(array->data+array->fill, item, array->word);
+		else memset(array->data+array->fill, 0, array->word);
+		array->fill += array->word;
+		array->count++;
+		#else
 		if(array->fill + array->word > array->size){
 			if(!array->next){
-				array->next = malloc(sizeof(hh_darray_t));
-				array->next->size = (array->size << 1) - (array->size >> 1);
-				array->next->fill = 0;
-				array->next->word = array->word;
-				array->next->next = 0;
-				array->next->data = malloc(array->next->size);
+				hh_darray_add_segment(array, array, (array->size << 1) - (array->size >> 1));
 			}
 			hh_darray_append(array->next, item);
 		}else{
@@ -122,6 +346,7 @@ void hh_darray_clear(hh_darray_t* array);
 			else memset(array->data+array->fill, 0, array->word);
 			array->fill += array->word;
 		}
+		#endif
 	}
 	
 	//-----------------------------------------------------------------------------
@@ -134,11 +359,19 @@ void hh_darray_clear(hh_darray_t* array);
 	}
 	//-----------------------------------------------------------------------------
 	void hh_darray_popend(hh_darray_t* array, void* item){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		array->fill -= array->word;
+		array->count--;
+		if(item) memcpy(item, array->data+array->fill, array->word);
+		#else
 		if(array->next){
 			hh_darray_popend(array->next, item);
 			if(array->next->fill == 0){
 				hh_darray_deinit(array->next);
-				free(array->next);
+				hh_darray_mem_free(array, array->next, sizeof(hh_darray_t));
+				#ifdef HH_DARRAY_STATS
+				array->stats->segments--;
+				#endif
 				array->next = 0;
 			}
 		}else{
@@ -146,9 +379,15 @@ void hh_darray_clear(hh_darray_t* array);
 			if(item) memcpy(item, array->data+array->fill, array->word);
 			memset(array->data+array->fill, 0, array->word);
 		}
+		#endif
 	}
 	//-----------------------------------------------------------------------------
 	void hh_darray_get(hh_darray_t* array, size_t index, void* item){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(index < array->count){
+			memcpy(item, array->data+(index*array->word), array->word);
+		}
+		#else
 		if(index >= array->size / array->word){
 			if(array->next){
 				index -= array->fill / array->word;
@@ -157,9 +396,16 @@ void hh_darray_clear(hh_darray_t* array);
 		}else if(index < array->fill / array->word){
 			memcpy(item, array->data+(index*array->word), array->word);
 		}
+		#endif
 	}
 	//-----------------------------------------------------------------------------
 	void hh_darray_set(hh_darray_t* array, size_t index, void* item){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(index < array->count){
+			if(item) memcpy(array->data+(index*array->word), item, array->word);
+			else memset(array->data+(index*array->word), 0, array->word);
+		}
+		#else
 		if(index >= array->size / array->word){
 			if(array->next){
 				index -= array->fill / array->word;
@@ -169,28 +415,43 @@ void hh_darray_clear(hh_darray_t* array);
 			if(item) memcpy(array->data+(index*array->word), item, array->word);
 			else memset(array->data+(index*array->word), 0, array->word);
 		}
+		#endif
 	}
 	//-----------------------------------------------------------------------------
 	void hh_darray_push(hh_darray_t* array, size_t index, void* item){
+		#ifdef HH_DARRAY_STATS
+		array->stats->linear_ops++;
+		#endif
 		hh_darray_append(array, 0);
-		void *buffer = malloc(array->word);
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(index >= array->count) return;
+		memmove(array->data+((index+1)*array->word), array->data+(index*array->word), 
+				(array->count-1-index)*array->word);
+		#else
 		for(size_t i = hh_darray_get_item_fill(array)-1; i > index ; i--){
-			hh_darray_get(array, i-1, buffer);
-			hh_darray_set(array, i, buffer);
+			memcpy(hh_darray_get_reference(array, i), hh_darray_get_reference(array, i-1), array->word);
 		}
-		free(buffer);
+		#endif
 		hh_darray_set(array, index, item);	
 	}
 	//-----------------------------------------------------------------------------
 	void hh_darray_pop(hh_darray_t* array, size_t index, void* item){
+		#ifdef HH_DARRAY_STATS
+		array->stats->linear_ops++;
+		#endif
 		if(item) hh_darray_get(array, index, item);
-		void *buffer = malloc(array->word);
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(index >= array->count) return;
+		memmove(array->data+(index*array->word), array->data+((index+1)*array->word), 
+				(array->count-1-index)*array->word);
+		array->fill -= array->word;
+		array->count--;
+		#else
 		for(size_t i = index; i < hh_darray_get_item_fill(array)-1; i++){
-			hh_darray_get(array, i+1, buffer);
-			hh_darray_set(array, i, buffer);
+			memcpy(hh_darray_get_reference(array, i), hh_darray_get_reference(array, i+1), array->word);
 		}
-		free(buffer);
 		hh_darray_popend(array, 0);
+		#endif
 	}
 	//-----------------------------------------------------------------------------
 	size_t hh_darray_get_fill(hh_darray_t* array){
@@ -210,18 +471,35 @@ void hh_darray_clear(hh_darray_t* array);
 	}
 	//-----------------------------------------------------------------------------
 	size_t hh_darray_get_item_fill(hh_darray_t* array){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		return(array->count);
+		#else
 		return(hh_darray_get_fill(array) / array->word);
+		#endif
 	}
 
 	//-----------------------------------------------------------------------------
 	size_t hh_darray_is_inside(hh_darray_t* array, void* item){
+		#ifdef HH_DARRAY_STATS
+		array->stats->linear_ops++;
+		#endif
+		#ifdef HH_DARRAY_CONTIGUOUS
+		for(size_t i = 0; i < array->count; i++){
+			if(memcmp(array->data+(i*array->word), item, array->word) == 0) return i;
+		}
+		#else
 		for(size_t i = 0; i < hh_darray_get_item_fill(array); i++){
 			if(memcmp(hh_darray_get_reference(array, i), item, array->word) == 0) return i;
 		}
+		#endif
 		return -1;
 	}
 	//-----------------------------------------------------------------------------
 	void* hh_darray_get_reference(hh_darray_t* array, size_t index){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(index >= array->count) return 0; // Index out of bounds
+		return (void*)(array->data + (index * array->word));
+		#else
 		if(index >= array->size/array->word){
 			if(array->next){
 				index -= array->size/array->word;
@@ -231,6 +509,7 @@ void hh_darray_clear(hh_darray_t* array);
 		}else{
 			return (void*)(array->data + (index * array->word));
 		}
+		#endif
 	}
 	//-----------------------------------------------------------------------------
 	void* hh_darray_get_end_reference(hh_darray_t* array){
@@ -247,10 +526,165 @@ void hh_darray_clear(hh_darray_t* array);
 		}
 	}
 	//-----------------------------------------------------------------------------
+	void hh_darray_reserve(hh_darray_t* array, size_t items){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(items*array->word > array->size){
+			array->data = hh_darray_mem_realloc(array, array->data, array->size, items*array->word);
+			array->size = items*array->word;
+		}
+		#else
+		size_t capacity = 0;
+		hh_darray_t *last = array;
+		while(1){
+			capacity += last->size / last->word;
+			if(!last->next) break;
+			last = last->next;
+		}
+		if(capacity >= items) return;
+		// Grown in place, a chained empty segment would break popend and the
+		// indexing, which expect every segment but the last to be full
+		size_t size = last->size + (items - capacity) * array->word;
+		last->data = hh_darray_mem_realloc(array, last->data, last->size, size);
+		last->size = size;
+		#endif
+	}
+	//-----------------------------------------------------------------------------
+	void hh_darray_append_n(hh_darray_t* array, void* items, size_t n){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		if(array->fill + n*array->word > array->size){
+			size_t grown = ((array->size << 1) - (array->size >> 1)) / array->word;
+			hh_darray_reserve(array, array->count + n > grown ? array->count + n : grown);
+		}
+		if(items) memcpy(array->data+array->fill, items, n*array->word);
+		else memset(array->data+array->fill, 0, n*array->word);
+		array->fill += n*array->word;
+		array->count += n;
+		#else
+		while(n){
+			if(array->fill + array->word > array->size){
+				if(!array->next){
+					// Grows this last segment in place
+					size_t grown = ((array->size << 1) - (array->size >> 1)) / array->word;
+					hh_darray_reserve(array, array->size / array->word + (n > grown ? n : grown));
+					continue;
+				}
+				array = array->next;
+				continue;
+			}
+			size_t fit = (array->size - array->fill) / array->word;
+			if(fit > n) fit = n;
+			if(items){
+				memcpy(array->data+array->fill, items, fit*array->word);
+				items += fit*array->word;
+			}
+			else memset(array->data+array->fill, 0, fit*array->word);
+			array->fill += fit*array->word;
+			n -= fit;
+		}
+		#endif
+	}
+	//-----------------------------------------------------------------------------
+	void hh_darray_extend_from(hh_darray_t* array, hh_darray_t* source){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		hh_darray_append_n(array, source->data, source->count);
+		#else
+		hh_darray_reserve(array, hh_darray_get_item_fill(array) + hh_darray_get_item_fill(source));
+		for(; source; source = source->next){
+			hh_darray_append_n(array, source->data, source->fill / source->word);
+		}
+		#endif
+	}
+	//-----------------------------------------------------------------------------
+	void* hh_darray_to_contiguous(hh_darray_t* array){
+		#ifndef HH_DARRAY_CONTIGUOUS
+		if(!array->next) return array->data;
+		size_t fill = hh_darray_get_fill(array);
+		size_t size = hh_darray_get_size(array);
+		void *data = hh_darray_mem_realloc(array, 0, 0, size);
+		size_t offset = 0;
+		for(hh_darray_t *segment = array; segment; segment = segment->next){
+			memcpy(data+offset, segment->data, segment->fill);
+			offset += segment->fill;
+		}
+		hh_darray_deinit(array->next);
+		hh_darray_mem_free(array, array->next, sizeof(hh_darray_t));
+		hh_darray_mem_free(array, array->data, array->size);
+		#ifdef HH_DARRAY_STATS
+		array->stats->segments--;
+		#endif
+		array->next = 0;
+		array->data = data;
+		array->size = size;
+		array->fill = fill;
+		#endif
+		return array->data;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_darray_shards_init(hh_darray_shards_t* shards, size_t word, size_t count){
+		shards->count = count;
+		shards->buffer = HH_DARRAY_MALLOC(count * sizeof(hh_darray_shard_t) + 64);
+		shards->shards = (hh_darray_shard_t*)(((uintptr_t)shards->buffer + 63) & ~(uintptr_t)63);
+		for(size_t i = 0; i < count; i++){
+			hh_darray_init(&shards->shards[i].array, word);
+			#ifdef HH_DARRAY_STATS
+			shards->shards[i].stats = (hh_darray_stats_t){.tag = "shard"};
+			hh_darray_set_stats(&shards->shards[i].array, &shards->shards[i].stats);
+			#endif
+		}
+	}
+	//-----------------------------------------------------------------------------
+	void hh_darray_shards_deinit(hh_darray_shards_t* shards){
+		for(size_t i = 0; i < shards->count; i++) hh_darray_deinit(&shards->shards[i].array);
+		HH_DARRAY_FREE(shards->buffer);
+		memset(shards, 0, sizeof(hh_darray_shards_t));
+	}
+	//-----------------------------------------------------------------------------
+	hh_darray_t* hh_darray_shards_get(hh_darray_shards_t* shards, size_t index){
+		return &shards->shards[index].array;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_darray_shards_merge(hh_darray_shards_t* shards, hh_darray_t* array){
+		size_t total = hh_darray_get_item_fill(array);
+		for(size_t i = 0; i < shards->count; i++) total += hh_darray_get_item_fill(&shards->shards[i].array);
+		hh_darray_reserve(array, total);
+		for(size_t i = 0; i < shards->count; i++) hh_darray_extend_from(array, &shards->shards[i].array);
+	}
+	//-----------------------------------------------------------------------------
+	#ifdef HH_DARRAY_STATS
+	void hh_darray_set_stats(hh_darray_t* array, hh_darray_stats_t* stats){
+		hh_darray_stats_t *old = array->stats;
+		size_t bytes = 0, segments = 0;
+		for(hh_darray_t *segment = array; segment; segment = segment->next){
+			bytes += segment->size;
+			if(segment != array){
+				bytes += sizeof(hh_darray_t);
+				segments++;
+			}
+			segment->stats = stats;
+		}
+		old->live_bytes -= bytes;
+		old->segments -= segments;
+		stats->live_bytes += bytes;
+		stats->segments += segments;
+		if(stats->live_bytes > stats->peak_bytes) stats->peak_bytes = stats->live_bytes;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_darray_dump_stats(hh_darray_stats_t* stats, FILE* file){
+		fprintf(file, "[HH_DARRAY] %-16s live: %zu B | peak: %zu B | allocs: %zu | segments: %zu | linear ops: %zu\n",
+				stats->tag ? stats->tag : "?", stats->live_bytes, stats->peak_bytes, 
+				stats->allocations, stats->segments, stats->linear_ops);
+	}
+	#endif
+	//-----------------------------------------------------------------------------
 	void hh_darray_clear(hh_darray_t* array){
+		#ifdef HH_DARRAY_CONTIGUOUS
+		array->fill = 0;
+		array->count = 0;
+		#else
 		while(array->fill){
 			hh_darray_popend(array, 0);
 		}
+		#endif
 	}
 
 	#endif
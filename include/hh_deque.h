@@ -0,0 +1,170 @@
+//-----------------------------------------------------------------------------
+// Ring buffer double ended queue, companion of hh_darray
+// Use "#define HH_DEQUE_IMPLEMENTATION" ones in your .c file to
+// implement the functions of the library
+//-----------------------------------------------------------------------------
+// Author		: github.com/SMDHuman
+// Last Update	: 17.10.2026
+//-----------------------------------------------------------------------------
+#ifndef HH_DEQUE_INIT_SIZE
+#define HH_DEQUE_INIT_SIZE 16 // Must be a power of two
+#endif
+
+// If defined, all function names start with hdq_*, else hh_deque_*
+//#define HH_DEQUE_SHORT_PREFIX
+
+#ifndef HH_DEQUE_H
+#define HH_DEQUE_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+typedef struct hh_deque_t{
+	size_t size; // How many items it can hold before growing (power of two)
+	size_t count; // How many items it holds
+	size_t head; // Index of the first item in the buffer
+	size_t word; // Word size in bytes
+	void *data; // Data buffer location
+}hh_deque_t;
+
+#ifdef HH_DEQUE_SHORT_PREFIX
+#define hdq_init hh_deque_init
+#define hdq_deinit hh_deque_deinit
+#define hdq_push_back hh_deque_push_back
+#define hdq_push_back_no_dupe hh_deque_push_back_no_dupe
+#define hdq_push_front hh_deque_push_front
+#define hdq_pop_back hh_deque_pop_back
+#define hdq_pop_front hh_deque_pop_front
+#define hdq_get hh_deque_get
+#define hdq_get_item_fill hh_deque_get_item_fill
+#define hdq_is_inside hh_deque_is_inside
+#define hdq_get_reference hh_deque_get_reference
+#define hdq_clear hh_deque_clear
+#endif
+
+// Initialize the deque
+void hh_deque_init(hh_deque_t* deque, size_t word);
+// Deinitialize the deque
+void hh_deque_deinit(hh_deque_t* deque);
+// Add the item to the back of the deque
+void hh_deque_push_back(hh_deque_t* deque, void* item);
+// Add the item to the back of the deque if its not already inside
+int hh_deque_push_back_no_dupe(hh_deque_t* deque, void* item);
+// Add the item to the front of the deque
+void hh_deque_push_front(hh_deque_t* deque, void* item);
+// Take the item from the back of the deque
+void hh_deque_pop_back(hh_deque_t* deque, void* item);
+// Take the item from the front of the deque
+void hh_deque_pop_front(hh_deque_t* deque, void* item);
+// Get the item with index counted from the front
+void hh_deque_get(hh_deque_t* deque, size_t index, void* item);
+// Get how many items it holds
+size_t hh_deque_get_item_fill(hh_deque_t* deque);
+// Check if an item inside the deque
+size_t hh_deque_is_inside(hh_deque_t* deque, void* item);
+// Returns the pointer to the item with index counted from the front
+void* hh_deque_get_reference(hh_deque_t* deque, size_t index);
+// Remove all elements
+void hh_deque_clear(hh_deque_t* deque);
+
+//-----------------------------------------------------------------------------
+// hh_deque function implementations
+	#ifdef HH_DEQUE_IMPLEMENTATION
+
+	void hh_deque_init(hh_deque_t* deque, size_t word){
+		deque->size = HH_DEQUE_INIT_SIZE;
+		deque->count = 0;
+		deque->head = 0;
+		deque->word = word;
+		deque->data = malloc(deque->size * word);
+	}
+	//-----------------------------------------------------------------------------
+	void hh_deque_deinit(hh_deque_t* deque){
+		free(deque->data);
+		memset(deque, 0, sizeof(hh_deque_t));
+	}
+	//-----------------------------------------------------------------------------
+	// Doubles the buffer and unwraps the items to the start of it
+	static void hh_deque_grow(hh_deque_t* deque){
+		size_t new_size = deque->size << 1;
+		void *new_data = malloc(new_size * deque->word);
+		size_t first = deque->size - deque->head;
+		if(first > deque->count) first = deque->count;
+		memcpy(new_data, deque->data+(deque->head*deque->word), first*deque->word);
+		memcpy(new_data+(first*deque->word), deque->data, (deque->count-first)*deque->word);
+		free(deque->data);
+		deque->data = new_data;
+		deque->size = new_size;
+		deque->head = 0;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_deque_push_back(hh_deque_t* deque, void* item){
+		if(deque->count == deque->size) hh_deque_grow(deque);
+		size_t slot = (deque->head + deque->count) & (deque->size - 1);
+		if(item) memcpy(deque->data+(slot*deque->word), item, deque->word);
+		else memset(deque->data+(slot*deque->word), 0, deque->word);
+		deque->count++;
+	}
+	//-----------------------------------------------------------------------------
+	int hh_deque_push_back_no_dupe(hh_deque_t* deque, void* item){
+		if(hh_deque_is_inside(deque, item) == (size_t)-1){
+			hh_deque_push_back(deque, item);
+			return 1;
+		}
+		return 0;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_deque_push_front(hh_deque_t* deque, void* item){
+		if(deque->count == deque->size) hh_deque_grow(deque);
+		deque->head = (deque->head - 1) & (deque->size - 1);
+		if(item) memcpy(deque->data+(deque->head*deque->word), item, deque->word);
+		else memset(deque->data+(deque->head*deque->word), 0, deque->word);
+		deque->count++;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_deque_pop_back(hh_deque_t* deque, void* item){
+		if(deque->count == 0) return;
+		deque->count--;
+		size_t slot = (deque->head + deque->count) & (deque->size - 1);
+		if(item) memcpy(item, deque->data+(slot*deque->word), deque->word);
+	}
+	//-----------------------------------------------------------------------------
+	void hh_deque_pop_front(hh_deque_t* deque, void* item){
+		if(deque->count == 0) return;
+		if(item) memcpy(item, deque->data+(deque->head*deque->word), deque->word);
+		deque->head = (deque->head + 1) & (deque->size - 1);
+		deque->count--;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_deque_get(hh_deque_t* deque, size_t index, void* item){
+		void *ref = hh_deque_get_reference(deque, index);
+		if(ref) memcpy(item, ref, deque->word);
+	}
+	//-----------------------------------------------------------------------------
+	size_t hh_deque_get_item_fill(hh_deque_t* deque){
+		return deque->count;
+	}
+	//-----------------------------------------------------------------------------
+	size_t hh_deque_is_inside(hh_deque_t* deque, void* item){
+		for(size_t i = 0; i < deque->count; i++){
+			size_t slot = (deque->head + i) & (deque->size - 1);
+			if(memcmp(deque->data+(slot*deque->word), item, deque->word) == 0) return i;
+		}
+		return -1;
+	}
+	//-----------------------------------------------------------------------------
+	void* hh_deque_get_reference(hh_deque_t* deque, size_t index){
+		if(index >= deque->count) return 0; // Index out of bounds
+		size_t slot = (deque->head + index) & (deque->size - 1);
+		return (void*)(deque->data + (slot * deque->word));
+	}
+	//-----------------------------------------------------------------------------
+	void hh_deque_clear(hh_deque_t* deque){
+		deque->count = 0;
+		deque->head = 0;
+	}
+
+	#endif
+#endif
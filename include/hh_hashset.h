@@ -0,0 +1,159 @@
+//-----------------------------------------------------------------------------
+// Open addressing hash set for fixed size keys, companion of hh_darray
+// Use "#define HH_HASHSET_IMPLEMENTATION" ones in your .c file to
+// implement the functions of the library
+//-----------------------------------------------------------------------------
+// Author		: github.com/SMDHuman
+// Last Update	: 17.10.2026
+//-----------------------------------------------------------------------------
+#ifndef HH_HASHSET_INIT_SIZE
+#define HH_HASHSET_INIT_SIZE 16 // Must be a power of two
+#endif
+
+// If defined, all function names start with hhs_*, else hh_hashset_*
+//#define HH_HASHSET_SHORT_PREFIX
+
+#ifndef HH_HASHSET_H
+#define HH_HASHSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+typedef struct hh_hashset_t{
+	size_t size; // How many slots it has (power of two)
+	size_t count; // How many keys it holds
+	size_t word; // Key size in bytes
+	uint8_t *used; // Slot occupancy flags
+	void *data; // Key buffer location
+}hh_hashset_t;
+
+#ifdef HH_HASHSET_SHORT_PREFIX
+#define hhs_init hh_hashset_init
+#define hhs_deinit hh_hashset_deinit
+#define hhs_insert hh_hashset_insert
+#define hhs_contains hh_hashset_contains
+#define hhs_remove hh_hashset_remove
+#define hhs_get_item_fill hh_hashset_get_item_fill
+#define hhs_clear hh_hashset_clear
+#endif
+
+// Initialize the set
+void hh_hashset_init(hh_hashset_t* set, size_t word);
+// Deinitialize the set
+void hh_hashset_deinit(hh_hashset_t* set);
+// Add the key to the set, returns 1 if it was not already inside
+int hh_hashset_insert(hh_hashset_t* set, void* key);
+// Check if the key is inside the set
+int hh_hashset_contains(hh_hashset_t* set, void* key);
+// Remove the key from the set, returns 1 if it was inside
+int hh_hashset_remove(hh_hashset_t* set, void* key);
+// Get how many keys it holds
+size_t hh_hashset_get_item_fill(hh_hashset_t* set);
+// Remove all keys
+void hh_hashset_clear(hh_hashset_t* set);
+
+//-----------------------------------------------------------------------------
+// hh_hashset function implementations
+	#ifdef HH_HASHSET_IMPLEMENTATION
+
+	// FNV-1a over the key bytes with a final avalanche
+	static size_t hh_hashset_hash(const void* key, size_t word){
+		const uint8_t *bytes = key;
+		uint64_t hash = 1469598103934665603ULL;
+		for(size_t i = 0; i < word; i++){
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		hash ^= hash >> 32;
+		return (size_t)hash;
+	}
+	//-----------------------------------------------------------------------------
+	// Slot of the key, or the empty slot where it would be placed
+	static size_t hh_hashset_find(hh_hashset_t* set, const void* key){
+		size_t slot = hh_hashset_hash(key, set->word) & (set->size - 1);
+		while(set->used[slot]){
+			if(memcmp(set->data+(slot*set->word), key, set->word) == 0) break;
+			slot = (slot + 1) & (set->size - 1);
+		}
+		return slot;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_hashset_init(hh_hashset_t* set, size_t word){
+		set->size = HH_HASHSET_INIT_SIZE;
+		set->count = 0;
+		set->word = word;
+		set->used = calloc(set->size, 1);
+		set->data = malloc(set->size * word);
+	}
+	//-----------------------------------------------------------------------------
+	void hh_hashset_deinit(hh_hashset_t* set){
+		free(set->used);
+		free(set->data);
+		memset(set, 0, sizeof(hh_hashset_t));
+	}
+	//-----------------------------------------------------------------------------
+	static void hh_hashset_grow(hh_hashset_t* set){
+		hh_hashset_t old = *set;
+		set->size = old.size << 1;
+		set->used = calloc(set->size, 1);
+		set->data = malloc(set->size * set->word);
+		for(size_t i = 0; i < old.size; i++){
+			if(!old.used[i]) continue;
+			size_t slot = hh_hashset_find(set, old.data+(i*old.word));
+			set->used[slot] = 1;
+			memcpy(set->data+(slot*set->word), old.data+(i*old.word), set->word);
+		}
+		free(old.used);
+		free(old.data);
+	}
+	//-----------------------------------------------------------------------------
+	int hh_hashset_insert(hh_hashset_t* set, void* key){
+		// Keep the load factor under 3/4
+		if((set->count + 1) * 4 > set->size * 3) hh_hashset_grow(set);
+		size_t slot = hh_hashset_find(set, key);
+		if(set->used[slot]) return 0;
+		set->used[slot] = 1;
+		memcpy(set->data+(slot*set->word), key, set->word);
+		set->count++;
+		return 1;
+	}
+	//-----------------------------------------------------------------------------
+	int hh_hashset_contains(hh_hashset_t* set, void* key){
+		return set->used[hh_hashset_find(set, key)];
+	}
+	//-----------------------------------------------------------------------------
+	int hh_hashset_remove(hh_hashset_t* set, void* key){
+		size_t hole = hh_hashset_find(set, key);
+		if(!set->used[hole]) return 0;
+		set->used[hole] = 0;
+		set->count--;
+		// Shift the following keys of the probe chain back into the hole
+		size_t slot = hole;
+		while(1){
+			slot = (slot + 1) & (set->size - 1);
+			if(!set->used[slot]) break;
+			size_t home = hh_hashset_hash(set->data+(slot*set->word), set->word) & (set->size - 1);
+			// Skip keys whose home lies cyclically in (hole, slot]
+			if(hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot)) continue;
+			memcpy(set->data+(hole*set->word), set->data+(slot*set->word), set->word);
+			set->used[hole] = 1;
+			set->used[slot] = 0;
+			hole = slot;
+		}
+		return 1;
+	}
+	//-----------------------------------------------------------------------------
+	size_t hh_hashset_get_item_fill(hh_hashset_t* set){
+		return set->count;
+	}
+	//-----------------------------------------------------------------------------
+	void hh_hashset_clear(hh_hashset_t* set){
+		memset(set->used, 0, set->size);
+		set->count = 0;
+	}
+
+	#endif
+#endif
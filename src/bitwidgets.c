@@ -8,15 +8,65 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <time.h>
+#include <ctype.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
 #define HH_ARGPARSE_SHORT_PREFIX
 #define HH_ARGPARSE_IMPLEMENTATION
 #include "hh_argparse.h"
 
 #define HH_DARRAY_SHORT_PREFIX
+#define HH_DARRAY_CONTIGUOUS
 #define HH_DARRAY_IMPLEMENTATION
 #include "hh_darray.h"
 
+#define HH_DEQUE_SHORT_PREFIX
+#define HH_DEQUE_IMPLEMENTATION
+#include "hh_deque.h"
+
+#define HH_ARENA_IMPLEMENTATION
+#include "hh_arena.h"
+
+#define HH_BITSET_SHORT_PREFIX
+#define HH_BITSET_IMPLEMENTATION
+#include "hh_bitset.h"
+
+#define HH_HASHSET_SHORT_PREFIX
+#define HH_HASHSET_IMPLEMENTATION
+#include "hh_hashset.h"
+
+#define BITWID_MAX_WORKERS 16 // Upper limit of threads used while loading
+#define BITWID_ROWS_PER_WORKER 64 // Least image rows given to a loader thread
+#define BITWID_HEADLESS_BATCH 65536 // Most steps simulated per call when headless
+#define BITWID_SAMPLE_FLUSH 65536 // Sample words buffered before writing them out
+#define BITWID_PIN_NAME 32 // Longest pin name with its terminator
+#define BITWID_LANES 64 // Circuit copies the lane simulator runs side by side
+#define BITWID_EXHAUSTIVE_INPUTS 20 // Most inputs whose every combination is tried
+#define BITWID_RANDOM_BATCHES 1024 // Lane batches of random inputs above that
+#define BITWID_VECTOR_TICKS 256 // Default steps every input vector is held for
+#define BITWID_TRUTH_INPUTS 24 // Most inputs a truth table is made for
+#define BITWID_TRUTH_ROW_INPUTS 10 // Most inputs the table is printed row by row for
+#define BITWID_RECORD_CHUNK 65536 // Bytes of changes gathered before a chunk is handed off
+#define BITWID_STATE_MAGIC "BWSTATE1" // First bytes of a state file
+#define BITWID_BREAK_EXPRESSION 128 // Longest breakpoint expression with its terminator
+#define BITWID_RELOAD_SETTLE_MS 100 // Quiet time after the image is written before it is loaded again
+#define BITWID_EDIT_REACH 3 // Farthest pixel whose wire a single pixel edit can join or split
+#define BITWID_HISTORY_BUDGET (64 << 20) // Bytes of rewind history kept by the window
+#define BITWID_PROBE_TICKS (1 << 20) // History kept per probe, a multiple of 64^BITWID_PROBE_LEVELS
+#define BITWID_PROBE_LEVELS 3 // Summaries over blocks of 64, 4096 and 262144 ticks
+#define BITWID_PROBE_HEIGHT 24 // Pixel height of a probe strip
+#define BITWID_ACTIVITY_PLANES 8 // Bits of the bit sliced toggle counters
+// Per wire toggle counters and the heatmap overlay, off unless defined
+//#define BITWID_ACTIVITY
+#define NO_WIRE UINT32_MAX
+
 //-----------------------------------------------------------------------------
 // Enums
 typedef enum{
@@ -49,6 +99,10 @@ typedef enum{
 }wire_color_e;
 //-----------------------------------------------------------------------------
 // Structs
+typedef struct{
+	size_t x, y;
+}pixel_t;
+
 typedef struct{
 	size_t x, y;
 	size_t input_wire_id;
@@ -58,13 +112,49 @@ typedef struct{
 }gate_t;
 
 typedef struct{
-	wire_state_e state;
-	wire_state_e state_buf;
-	bool touchable;
-	hh_darray_t pixels; // sizeof(sizet_t)*2
+	hh_darray_t pixels; // sizeof(pixel_t)
 	wire_color_e color;
 }wire_t;
 
+typedef struct{
+	pixel_t pixel;
+	uint32_t wire_id;
+}wire_pixel_t;
+
+typedef struct{
+	uint64_t tick; // Step it is applied before
+	uint32_t wire_id;
+	uint32_t line; // Line in the file, later lines win on the same tick
+	bool value;
+}stimulus_event_t;
+
+typedef struct{
+	char name[BITWID_PIN_NAME];
+	uint32_t wire_id;
+	bool input; // Wire is not driven by a gate, it can be set
+}pin_t;
+
+typedef struct{
+	uint64_t tick; // Steps simulated when the change was seen
+	uint32_t pin;
+	bool value;
+}watch_event_t;
+
+HH_DARRAY_DEFINE(gate_t, gates)
+HH_DARRAY_DEFINE(wire_t, wires)
+HH_DARRAY_DEFINE(pixel_t, pixels)
+HH_DARRAY_DEFINE(wire_pixel_t, wire_pixels)
+HH_DARRAY_DEFINE(stimulus_event_t, events)
+HH_DARRAY_DEFINE(pin_t, pins)
+HH_DARRAY_DEFINE(uint32_t, pin_ids)
+HH_DARRAY_DEFINE(watch_event_t, watch_events)
+
+// Shown while loading and printed when a stage starts
+static const char* load_stage_names[] = {
+	"Loading image...", "Counting gates and wires...", "Extracting gates...", 
+	"Extracting Wires...", "Attaching gates and wires...", "Ready!"
+};
+
 //-----------------------------------------------------------------------------
 // BitWidget structs and functions definitions
 typedef struct{
@@ -72,23 +162,315 @@ typedef struct{
     Image image;
     hh_darray_t gates; // sizeof(gate_t)
     hh_darray_t wires; // sizeof(wire_t)
-    hh_darray_t crossings; // sizeof(size_t)*2
+    hh_darray_t crossings; // sizeof(pixel_t)
+    hh_bitmap_t crossing_map; // Pixels listed in crossings
+    uint32_t* wire_plane; // Wire id of every image pixel, NO_WIRE if none
+    hh_bitmap_t gate_map; // Input and output pixels of every gate
+    uint64_t tick; // Steps simulated so far
+    hh_darray_t stimulus; // sizeof(stimulus_event_t), sorted by tick
+    size_t stimulus_cursor; // First stimulus event not applied yet
+    hh_darray_t pins; // sizeof(pin_t), named wires from the pin file
+    hh_darray_t watches; // sizeof(uint32_t), pins whose changes are logged
+    hh_darray_t watch_log; // sizeof(watch_event_t), changes not printed yet
+    hh_bitset_t state; // Wire states, one bit per wire
+    hh_bitset_t last_state; // Wire states after the previous step
+    hh_bitset_t changed; // Wires that changed in the last step
+    hh_bitset_t touchable; // Wires not driven by any gate
+    hh_bitset_t drive; // Gate outputs of the running step
+    struct recorder_t* recorder; // Waveform recorder, 0 if not recording
+    struct history_t* history; // Rewind history, 0 if not kept
+    struct load_progress_t* progress; // Told about bitwid_init stages, 0 if nobody watches
+    hh_darray_t probes; // sizeof(probe_t), wires with a waveform strip
+    hh_darray_t breakpoints; // sizeof(breakpoint_t)
+    size_t break_hit; // Breakpoint that stopped the simulation, -1 if none
+    uint64_t probe_span; // Ticks shown by the strips
+    #ifdef BITWID_ACTIVITY
+    uint64_t* activity; // Toggles of every wire, up to the last fold
+    uint64_t* activity_planes; // Bit sliced counters since the last fold, planes of a word side by side
+    uint32_t activity_pending; // Steps counted in the planes
+    bool show_heatmap; // Render activity instead of states
+    #endif
+    hh_arena_t arena; // Backs the wire pixel lists filled by bitwid_init, freed at once
+    hh_darray_allocator_t allocator; // Hands out memory from arena
+    #ifdef HH_DARRAY_STATS
+    hh_darray_stats_t gate_stats, wire_stats, pixel_stats, crossing_stats;
+    #endif
 }bit_widget_t;
 
+// Changes of a run of ticks. Every tick with changes is stored as varints of
+// the tick delta, the change count and the deltas of the toggled wire ids
+typedef struct{
+	uint64_t start_tick; // Tick of the snapshot
+	uint64_t last_tick; // Last tick stored in bytes
+	uint64_t* snapshot; // Wire states at start_tick
+	size_t wire_count; // Bits of the snapshot
+	hh_darray_t bytes; // sizeof(uint8_t)
+}record_chunk_t;
+
+// Keyframes and changes of the recent ticks within a memory budget, so the
+// window can show earlier states. A chunk is sealed and a new keyframe taken
+// once its changes outgrow the keyframe, memory follows the activity.
+typedef struct history_t{
+	hh_deque_t chunks; // sizeof(record_chunk_t*), sealed chunks oldest first
+	record_chunk_t* chunk; // Being filled
+	size_t bytes; // Held by the sealed chunks
+	size_t budget; // Most bytes the sealed chunks may hold
+	hh_bitset_t view; // Wire states at view_tick
+	uint64_t view_tick;
+	bool viewing; // Showing view instead of the live state, simulation paused
+	hh_darray_t ids; // sizeof(uint8_t), changes of the step being appended
+}history_t;
+
+// Builds a new widget on a background thread every time the image file is
+// written, the window takes it between steps with loader_take
+typedef struct{
+	char* filename;
+	char* pin_filename; // Loaded into every new widget, 0 to keep the one next to the image
+	int notify; // inotify descriptor watching the directory of the image
+	pthread_t thread;
+	pthread_mutex_t lock; // Guards ready and stop
+	bit_widget_t* ready; // Built and not taken yet
+	bool stop;
+}loader_t;
+
+// Stages of bitwid_init in order, LOAD_DONE once the widget can be used
+typedef enum{
+	LOAD_IMAGE,
+	LOAD_COUNT,
+	LOAD_GATES,
+	LOAD_WIRES,
+	LOAD_ATTACH,
+	LOAD_DONE
+}load_stage_e;
+
+// Filled in by bitwid_init_with_progress, read from other threads while it runs
+typedef struct load_progress_t{
+	pthread_mutex_t lock; // Guards stage and fraction
+	load_stage_e stage;
+	float fraction; // Part of the stage done, 0 to 1
+}load_progress_t;
+
+// Builds the first widget of the window, which polls progress meanwhile
+typedef struct{
+	bit_widget_t* widget;
+	char* filename;
+	load_progress_t progress;
+}init_worker_t;
+
+typedef struct recorder_t{
+	bit_widget_t* widget; // Never read by the writer, the widget changes meanwhile
+	size_t wire_count; // Wires when the recording started
+	size_t words; // Snapshot words of every chunk
+	hh_darray_t pins; // sizeof(pin_t), copy of the widget pins naming VCD wires
+	FILE* file;
+	bool vcd; // Write VCD text, else the binary chunk format
+	uint64_t ring_ticks; // Keep at least this many last ticks in memory, 0 streams to file
+	record_chunk_t* chunk; // Being filled by the simulation
+	hh_deque_t ring; // sizeof(record_chunk_t*), filled chunks kept in ring mode
+	hh_deque_t queue; // sizeof(record_chunk_t*), chunks waiting for the writer
+	pthread_mutex_t lock; // Guards queue and stop
+	pthread_cond_t wake;
+	pthread_t thread;
+	bool stop;
+	uint64_t* vcd_state; // Wire states written so far
+	bool header_written;
+	hh_darray_t ids; // sizeof(uint8_t), changes of the step being appended
+}recorder_t;
+
+typedef struct{
+	uint32_t clause; // Terms of a clause are next to each other
+	uint32_t word; // State word it tests
+	uint64_t ones; // Wires of the word that must be high
+	uint64_t zeros; // Wires of the word that must be low
+}break_term_t;
+
+typedef struct{
+	uint32_t word;
+	uint64_t mask;
+}word_mask_t;
+
+// Condition compiled to OR of clauses, each an AND of masked word tests
+typedef struct{
+	char expression[BITWID_BREAK_EXPRESSION];
+	hh_darray_t terms; // sizeof(break_term_t)
+	hh_darray_t triggers; // sizeof(word_mask_t), wires it reads, tested against changed
+	bool was_true; // Fires only when it turns true
+}breakpoint_t;
+
+HH_DARRAY_DEFINE(break_term_t, break_terms)
+HH_DARRAY_DEFINE(word_mask_t, word_masks)
+HH_DARRAY_DEFINE(breakpoint_t, breakpoints)
+
+typedef struct{
+	uint32_t wire_id;
+	uint64_t start_tick; // First tick recorded
+	uint64_t* history; // One bit per tick, a ring of BITWID_PROBE_TICKS
+	hh_bitset_t any[BITWID_PROBE_LEVELS]; // Blocks of 64^(level+1) ticks with a high tick
+	hh_bitset_t all[BITWID_PROBE_LEVELS]; // Blocks of 64^(level+1) ticks with only high ticks
+}probe_t;
+
+HH_DARRAY_DEFINE(probe_t, probes)
+
+typedef struct{
+	uint32_t wire_id;
+	uint32_t lane;
+	bool value;
+}lane_force_t;
+
+HH_DARRAY_DEFINE(lane_force_t, forces)
+
+// Runs BITWID_LANES copies of a circuit at once, one bit lane per copy
+typedef struct{
+	bit_widget_t* widget; // Circuit being simulated, only read
+	size_t wire_count;
+	uint64_t* state; // One word per wire, bit n is the wire in lane n
+	uint64_t* drive; // Gate outputs of the running step
+	uint64_t* hold; // All ones for touchable wires, zero for driven ones
+	uint64_t tick; // Steps simulated so far
+	size_t stimulus_cursor; // First stimulus event of the widget not applied yet
+	hh_darray_t forces; // sizeof(lane_force_t), wires stuck in single lanes
+}lane_sim_t;
+
+typedef struct{
+	uint32_t wire_id;
+	bool value; // Stuck-at value
+	uint64_t detected; // Tick the outputs first differed, UINT64_MAX if never
+}fault_t;
+
+HH_DARRAY_DEFINE(fault_t, faults)
+
 int bitwid_init(bit_widget_t* widget, char* filename);
+int bitwid_init_with_progress(bit_widget_t* widget, char* filename, load_progress_t* progress);
+static void report_load_stage(bit_widget_t* widget, load_stage_e stage);
+static void report_load_fraction(bit_widget_t* widget, float fraction);
+float get_load_progress(load_progress_t* progress, load_stage_e* stage);
+static void* init_worker(void* arg);
 void bitwid_deinit(bit_widget_t* widget);
 void bitwid_render_screen(bit_widget_t* widget, int x, int y, int scale);
+int bitwid_edit_pixel(bit_widget_t* widget, size_t x, size_t y, Color color);
+static size_t claim_wire_id(bit_widget_t* widget, hh_bitset_t* affected, size_t* next);
+static void resize_wire_states(bit_widget_t* widget, size_t wire_count);
+// Stops early at the step a breakpoint fires, see break_hit
 void bitwid_simulate(bit_widget_t* widget, int steps);
+int bitwid_load_stimulus(bit_widget_t* widget, char* filename);
+int bitwid_load_pins(bit_widget_t* widget, char* filename);
+size_t bitwid_find_pin(bit_widget_t* widget, const char* name);
+void bitwid_watch_pin(bit_widget_t* widget, size_t pin);
+void lane_sim_init(lane_sim_t* sim, bit_widget_t* widget);
+void lane_sim_deinit(lane_sim_t* sim);
+void lane_sim_reset(lane_sim_t* sim);
+void lane_sim_force(lane_sim_t* sim, size_t wire_id, size_t lane, bool value);
+void lane_sim_step(lane_sim_t* sim, uint64_t steps);
+static void apply_lane_forces(lane_sim_t* sim);
+static int run_fault_sim(bit_widget_t* widget, uint64_t ticks);
+static int run_equivalence(bit_widget_t* widget, char* other_filename, char* pin_filename, uint64_t ticks);
+static int copy_stimulus_by_pin(bit_widget_t* widget, bit_widget_t* other);
+static int run_truth_table(bit_widget_t* widget, uint64_t ticks);
+static uint64_t get_lane_pattern(uint64_t batch, size_t input);
+static uint64_t next_random(uint64_t* seed);
+static size_t get_observed_wires(bit_widget_t* widget, hh_darray_t* wire_ids);
+static void print_wire_name(bit_widget_t* widget, size_t wire_id);
+int recorder_start(bit_widget_t* widget, char* filename, uint64_t ring_ticks);
+void recorder_stop(bit_widget_t* widget);
+static void recorder_append(recorder_t* recorder, uint64_t tick, hh_bitset_t* changed);
+static record_chunk_t* new_record_chunk(hh_bitset_t* state, uint64_t tick);
+static void append_record_changes(record_chunk_t* chunk, uint64_t tick, hh_bitset_t* changed, hh_darray_t* ids);
+static void replay_record_chunk(record_chunk_t* chunk, uint64_t until, uint64_t* state);
+static void free_record_chunk(record_chunk_t* chunk);
+static void trim_record_chunk(record_chunk_t* chunk, uint64_t from);
+static void seal_record_chunk(recorder_t* recorder, uint64_t tick);
+static void* recorder_worker(void* arg);
+static void write_record_chunk(recorder_t* recorder, record_chunk_t* chunk);
+static void write_vcd_id(FILE* file, size_t wire_id);
+static void put_varint(hh_darray_t* bytes, uint64_t value);
+static uint64_t get_varint(uint8_t** cursor);
+void bitwid_enable_history(bit_widget_t* widget, size_t budget);
+void bitwid_disable_history(bit_widget_t* widget);
+bool bitwid_view_tick(bit_widget_t* widget, uint64_t tick);
+static void history_append(bit_widget_t* widget);
+loader_t* loader_start(char* filename, char* pin_filename);
+void loader_stop(loader_t* loader);
+static void* loader_worker(void* arg);
+bit_widget_t* loader_take(loader_t* loader);
+void bitwid_carry_over(bit_widget_t* widget, bit_widget_t* old);
+int bitwid_save_state(bit_widget_t* widget, char* filename);
+int bitwid_export_image(bit_widget_t* widget, char* filename);
+int bitwid_load_state(bit_widget_t* widget, char* filename);
+static uint64_t get_netlist_hash(bit_widget_t* widget);
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size);
+int bitwid_add_breakpoint(bit_widget_t* widget, const char* expression);
+void bitwid_report_break(bit_widget_t* widget);
+static bool eval_breakpoint(bit_widget_t* widget, breakpoint_t* breakpoint);
+static bool check_breakpoints(bit_widget_t* widget);
+bool bitwid_toggle_probe(bit_widget_t* widget, size_t wire_id);
+void bitwid_render_probes(bit_widget_t* widget, int x, int y, int width);
+static void record_probes(bit_widget_t* widget);
+static int get_probe_range(probe_t* probe, uint64_t from, uint64_t to);
+#ifdef BITWID_ACTIVITY
+void bitwid_dump_activity(bit_widget_t* widget, size_t top);
+static void count_activity(bit_widget_t* widget);
+static void fold_activity(bit_widget_t* widget);
+static int compare_activity(const void* a, const void* b);
+#endif
+static int setup_widget(bit_widget_t* widget, hh_argparse_t* argpar);
+static char* get_circuit_path(hh_argparse_t* argpar);
+static void flush_watch_log(bit_widget_t* widget);
+static bool is_pin_name(const char* name);
+static char* get_pin_filename(const char* filename);
+static int run_headless(bit_widget_t* widget, uint64_t ticks, uint64_t sample_every);
+static void flush_samples(hh_darray_t* samples);
+static double get_monotonic_time(void);
+static void apply_stimulus(bit_widget_t* widget);
+static int compare_stimulus_events(const void* a, const void* b);
+static size_t parse_wire_target(bit_widget_t* widget, const char* target);
+static void count_gates_and_wires(bit_widget_t* widget, size_t* gate_count, size_t* wire_bound);
 static void extract_gates(bit_widget_t* widget);
+static void* extract_gates_worker(void* arg);
+static void mark_gate(bit_widget_t* widget, gate_t* gate);
+static void find_gates_at(Image img, size_t x, size_t y, hh_darray_t* gates);
+static size_t get_worker_count(size_t rows);
 static void extract_wires(bit_widget_t* widget);
+static void flood_wire(bit_widget_t* widget, hh_bitmap_t* visited, size_t x, size_t y, uint32_t wire_id);
+static int enqueue_pixel(hh_deque_t* queue, hh_hashset_t* queued, size_t* pixel);
+static void add_crossing(bit_widget_t* widget, size_t x, size_t y);
+static void remove_crossing(bit_widget_t* widget, size_t x, size_t y);
+static wire_color_e get_unvisited_wire_color(bit_widget_t* widget, hh_bitmap_t* visited, size_t x, size_t y);
+static void init_wire_states(bit_widget_t* widget);
 static void attack_gate_to_wires(bit_widget_t* widget);
+static void attach_gate(bit_widget_t* widget, gate_t* gate);
 static wire_color_e get_wire_color(Color color);
 static bool get_wire_state(Color color);
 static Color lower_color(Color color);
 static size_t get_wire_from_pixel(bit_widget_t* widget, size_t x, size_t y);
-static size_t get_gate_from_pixel(bit_widget_t* widget, size_t x, size_t y);
 static void preprocess_image(bit_widget_t* widget);
 
+// Header of a state file, followed by the state words and pending events
+typedef struct{
+	char magic[8]; // BITWID_STATE_MAGIC
+	uint64_t netlist_hash;
+	uint64_t tick;
+	uint64_t wire_count;
+	uint64_t event_count;
+}state_header_t;
+
+// Stimulus event of a state file, every byte is a field so none is padding
+typedef struct{
+	uint64_t tick;
+	uint32_t wire_id;
+	uint32_t line;
+	uint8_t value;
+	uint8_t reserved[7]; // Zero
+}state_event_t;
+
+// State of a pin, the index comes from bitwid_find_pin
+static inline bool bitwid_get_pin(bit_widget_t* widget, size_t pin){
+	return hbs_test(&widget->state, pins_ref(&widget->pins, pin)->wire_id);
+}
+// Drive an input pin, the new state is seen by the next step
+static inline void bitwid_set_pin(bit_widget_t* widget, size_t pin, bool value){
+	hbs_assign(&widget->state, pins_ref(&widget->pins, pin)->wire_id, value);
+}
+
 //-----------------------------------------------------------------------------
 
 int main(int argc, char**argv){
@@ -100,6 +482,17 @@ int main(int argc, char**argv){
 	int simulation_rate = 60;
 	int target_fps = 60;
 	bool adjust_simrate = 0;
+	bool headless = 0;
+	uint64_t headless_ticks = 1000000;
+	uint64_t sample_every = 0;
+	uint64_t fault_ticks = 0;
+	char *save_file = 0;
+	char *export_file = 0;
+	char *compare_file = 0;
+	#ifdef BITWID_ACTIVITY
+	size_t activity_top = 0;
+	#endif
+	uint64_t truth_ticks = 0;
 	// Render Scale
 	if(hap_check_op_short_or_long(argpar, 's', "scale")){
 		char *rc_str = hap_get_op_short_or_long(argpar, 's', "scale");
@@ -117,6 +510,45 @@ int main(int argc, char**argv){
 	}
 	// Adjust Simulation Rate
 	adjust_simrate = hap_check_op_short_or_long(argpar, 'a', "adjust-simrate");
+	// Headless Run
+	headless = hap_check_op_short_or_long(argpar, 'H', "headless");
+	if(hap_check_op_short_or_long(argpar, 't', "ticks")){
+		char *tk_str = hap_get_op_short_or_long(argpar, 't', "ticks");
+		headless_ticks = strtoull(tk_str, 0, 10);
+	}
+	if(hap_check_op_short_or_long(argpar, 'e', "sample-every")){
+		char *se_str = hap_get_op_short_or_long(argpar, 'e', "sample-every");
+		sample_every = strtoull(se_str, 0, 10);
+	}
+	// Fault Simulation
+	if(hap_check_op_short_or_long(argpar, 'F', "fault-sim")){
+		char *ft_str = hap_get_op_short_or_long(argpar, 'F', "fault-sim");
+		fault_ticks = strtoull(ft_str, 0, 10);
+	}
+	// State File
+	if(hap_check_op_short_or_long(argpar, 'S', "save-state")){
+		save_file = hap_get_op_short_or_long(argpar, 'S', "save-state");
+	}
+	// Blueprint Export
+	if(hap_check_op_short_or_long(argpar, 'E', "export")){
+		export_file = hap_get_op_short_or_long(argpar, 'E', "export");
+	}
+	// Equivalence Check
+	if(hap_check_op_short_or_long(argpar, 'C', "compare")){
+		compare_file = hap_get_op_short_or_long(argpar, 'C', "compare");
+	}
+	// Truth Table
+	if(hap_check_op_short_or_long(argpar, 'T', "truth-table")){
+		char *tt_str = hap_get_op_short_or_long(argpar, 'T', "truth-table");
+		truth_ticks = strtoull(tt_str, 0, 10);
+	}
+	#ifdef BITWID_ACTIVITY
+	// Activity Report
+	if(hap_check_op_short_or_long(argpar, 'A', "activity-top")){
+		char *at_str = hap_get_op_short_or_long(argpar, 'A', "activity-top");
+		activity_top = strtoull(at_str, 0, 10);
+	}
+	#endif
 	// Help Message
 	if(hap_check_op_short_or_long(argpar, 'h', "help")){
 		printf("BitWidgets - A simple logic gate simulator using images as circuit blueprints.\n");
@@ -126,16 +558,92 @@ int main(int argc, char**argv){
 		printf("  -r, --rate <num>       Set simulation rate in Hz (default: 60)\n");
 		printf("  -f, --target-fps <num> Set target FPS for rendering (default: 60)\n");
 		printf("  -a, --adjust-simrate	 Enable automatic adjustment of simulation rate (default: disabled)\n");
+		printf("  -i, --stimulus <file>  Apply input events from file, lines of: <tick> <x>,<y>|#<wire_id>|<pin> <0|1>\n");
+		printf("  -p, --pins <file>      Name wires from file, lines of: <pin> <x>,<y>|#<wire_id>\n");
+		printf("                         (default: image path with .pins extension, if it exists)\n");
+		printf("  -v, --set <pin>=<0|1>  Set an input pin before the first step, can be repeated\n");
+		printf("  -w, --watch <pin>      Print changes of a pin as <tick> <pin>=<0|1>, can be repeated\n");
+		printf("  -H, --headless         Simulate without a window as fast as possible\n");
+		printf("  -t, --ticks <num>      Steps to simulate when headless (default: 1000000),\n");
+		printf("                         counted from the tick of -L if given\n");
+		printf("  -e, --sample-every <n> Print wire states every n steps when headless (default: never)\n");
+		printf("  -F, --fault-sim <n>    Simulate every stuck-at fault for n steps and report the ones\n");
+		printf("                         seen on the watched pins, or on all output pins if none\n");
+		printf("  -C, --compare <image>  Check the circuit against another one with the same pin names,\n");
+		printf("                         holding each input vector for -t steps (default: %d),\n", BITWID_VECTOR_TICKS);
+		printf("                         -p and -i apply to both circuits\n");
+		printf("  -T, --truth-table <n>  Print the outputs for every input combination after n steps\n");
+		printf("  -b, --break <expr>     Stop when the expression turns true, e.g. \"A & !#12 | 3,4\",\n");
+		printf("                         space resumes in the window, can be repeated\n");
+		printf("  -L, --load-state <file> Continue from a saved state of the same circuit\n");
+		printf("  -S, --save-state <file> Save the state and pending inputs at exit\n");
+		printf("  -E, --export <png>     Save the circuit with its wire states at exit as a new image\n");
+		printf("  -R, --record <file>    Record wire changes, as VCD if the file ends with .vcd\n");
+		printf("  -N, --record-ring <n>  Keep recent ticks in memory and write only the last n at exit\n");
+		#ifdef BITWID_ACTIVITY
+		printf("  -A, --activity-top <n> Print the n wires that toggled the most at exit, H shows a heatmap\n");
+		#endif
 		printf("  -h, --help             Show this help message\n");
+		printf("\nLeft click toggles an input wire, right click adds or removes a probe strip,\n");
+		printf("up and down zoom the probe strips in and out. Left and right step through the\n");
+		printf("recent ticks (shift for 64), enter returns to the live state. E toggles editing,\n");
+		printf("where 1-7 pick white, magenta, yellow, cyan, crossing, not gate and diode, left\n");
+		printf("click paints and right click erases. -E saves the edited circuit.\n");
 		return 0;
 	}
 	//-----------------------------------------------------------------------------
 	// Load Circuit Image
-	if(argc < 2){
+	char* circuit_path = get_circuit_path(argpar);
+	if(!circuit_path){
 		printf("Error: No circuit image file provided.\n");
+		printf("Usage: bitwidgets [options] <circuit_image_path>\n");
 		printf("Use -h or --help for usage information.\n");
+		hap_deinit(argpar);
 		return -1;
 	}
+	// Fault Simulation
+	if(fault_ticks){
+		bit_widget_t widget; bitwid_init(&widget, circuit_path);
+		int result = setup_widget(&widget, argpar);
+		if(result == 0) result = run_fault_sim(&widget, fault_ticks);
+		bitwid_deinit(&widget);
+		hap_deinit(argpar);
+		return result;
+	}
+	// Truth Table
+	if(truth_ticks){
+		bit_widget_t widget; bitwid_init(&widget, circuit_path);
+		int result = setup_widget(&widget, argpar);
+		if(result == 0) result = run_truth_table(&widget, truth_ticks);
+		bitwid_deinit(&widget);
+		hap_deinit(argpar);
+		return result;
+	}
+	// Equivalence Check
+	if(compare_file){
+		bit_widget_t widget; bitwid_init(&widget, circuit_path);
+		uint64_t vector_ticks = hap_check_op_short_or_long(argpar, 't', "ticks") ? headless_ticks : BITWID_VECTOR_TICKS;
+		char* pin_filename = hap_check_op_short_or_long(argpar, 'p', "pins") ? hap_get_op_short_or_long(argpar, 'p', "pins") : 0;
+		int result = setup_widget(&widget, argpar);
+		if(result == 0) result = run_equivalence(&widget, compare_file, pin_filename, vector_ticks);
+		bitwid_deinit(&widget);
+		hap_deinit(argpar);
+		return result;
+	}
+	// Headless Run
+	if(headless){
+		bit_widget_t widget; bitwid_init(&widget, circuit_path);
+		int result = setup_widget(&widget, argpar);
+		if(result == 0) result = run_headless(&widget, headless_ticks, sample_every);
+		if(result == 0 && save_file) result = bitwid_save_state(&widget, save_file);
+		if(result == 0 && export_file) result = bitwid_export_image(&widget, export_file);
+		#ifdef BITWID_ACTIVITY
+		if(result == 0 && activity_top) bitwid_dump_activity(&widget, activity_top);
+		#endif
+		bitwid_deinit(&widget);
+		hap_deinit(argpar);
+		return result;
+	}
 	// Initilize Raylib
 	SetConfigFlags(FLAG_WINDOW_UNDECORATED | 
 				   FLAG_WINDOW_TRANSPARENT | 
@@ -145,38 +653,149 @@ int main(int argc, char**argv){
 	//...
 
 	//...
-	bit_widget_t widget; bitwid_init(&widget, hap_get_positional(argpar, 0));
-	SetWindowSize(widget.image.width * render_scale, widget.image.height * render_scale);
+	// The image is shown at once while a thread builds the widget from it
+	char* filename = circuit_path;
+	Image preview = LoadImage(filename);
+	if(!preview.data){
+		printf("Error: Could not load %s\n", filename);
+		CloseWindow();
+		hap_deinit(argpar);
+		return -1;
+	}
+	SetWindowSize(preview.width * render_scale, preview.height * render_scale);
+	Texture2D preview_texture = LoadTextureFromImage(preview);
+	UnloadImage(preview);
+	// On the heap so a reloaded widget can take its place
+	bit_widget_t* widget = malloc(sizeof(bit_widget_t));
+	init_worker_t starter = {.widget = widget, .filename = filename};
+	pthread_mutex_init(&starter.progress.lock, 0);
+	pthread_t init_thread;
+	bool threaded = pthread_create(&init_thread, 0, init_worker, &starter) == 0;
+	// Without a thread the image is only shown once the widget is ready
+	if(!threaded) init_worker(&starter);
+	load_stage_e stage = LOAD_IMAGE;
+	bool loaded = true;
+	while(stage != LOAD_DONE){
+		if(WindowShouldClose()){
+			loaded = false;
+			break;
+		}
+		float done = get_load_progress(&starter.progress, &stage);
+		int width = preview_texture.width * render_scale;
+		int height = preview_texture.height * render_scale;
+		BeginDrawing();
+		ClearBackground((Color){0, 0, 0, 0});
+		DrawTextureEx(preview_texture, (Vector2){0, 0}, 0, render_scale, WHITE);
+		DrawRectangle(0, height - 14, width, 14, Fade(BLACK, 0.6f));
+		DrawRectangle(0, height - 2, width * done, 2, GREEN);
+		DrawText(load_stage_names[stage], 2, height - 12, 10, WHITE);
+		EndDrawing();
+	}
+	UnloadTexture(preview_texture);
+	// Closed while loading, the window goes at once and the widget is waited for
+	if(!loaded) CloseWindow();
+	if(threaded) pthread_join(init_thread, 0);
+	pthread_mutex_destroy(&starter.progress.lock);
+	if(!loaded || setup_widget(widget, argpar) != 0){
+		if(loaded) CloseWindow();
+		bitwid_deinit(widget);
+		free(widget);
+		hap_deinit(argpar);
+		return loaded ? -1 : 0;
+	}
+	SetWindowSize(widget->image.width * render_scale, widget->image.height * render_scale);
+	bitwid_enable_history(widget, BITWID_HISTORY_BUDGET);
+	loader_t* loader = loader_start(widget->filename, hap_get_op_short_or_long(argpar, 'p', "pins"));
+	// Colors the number keys pick while editing
+	const unsigned int edit_palette[] = {WIRE_WHITE, WIRE_MAGENTA, WIRE_YELLOW, WIRE_CYAN, WIRE_CROSSING, NOT_GATE, DIODE};
+	bool editing = false;
+	unsigned int edit_color = WIRE_WHITE;
 	//-----------------------------------------------------------------------------
 	// Main Loop
   while (!WindowShouldClose()){	
-		if(IsMouseButtonPressed(0)){
+		// Swap in the widget of a changed image
+		bit_widget_t* reloaded = loader_take(loader);
+		if(reloaded){
+			bitwid_carry_over(reloaded, widget);
+			bitwid_deinit(widget);
+			free(widget);
+			widget = reloaded;
+			bitwid_enable_history(widget, BITWID_HISTORY_BUDGET);
+			SetWindowSize(widget->image.width * render_scale, 
+						  widget->image.height * render_scale + probes_count(&widget->probes) * BITWID_PROBE_HEIGHT);
+			printf("[BITWIDGETS] Reloaded %s at tick %llu\n", widget->filename, (unsigned long long)widget->tick);
+		}
+		// Edit mode paints with left and erases with right
+		if(IsKeyPressed(KEY_E)){
+			editing = !editing;
+			printf("[BITWIDGETS] Editing %s\n", editing ? "on" : "off");
+		}
+		for(int i = 0; i < 7; i++){
+			if(IsKeyPressed(KEY_ONE + i)) edit_color = edit_palette[i];
+		}
+		if(editing && (IsMouseButtonDown(0) || IsMouseButtonDown(1))){
+			Color color = GetColor(IsMouseButtonDown(0) ? edit_color : SPACE);
+			bitwid_edit_pixel(widget, GetMouseX() / render_scale, GetMouseY() / render_scale, color);
+		}
+		if(!editing && IsMouseButtonPressed(0)){
 			int mouse_x = GetMouseX() / render_scale;
 			int mouse_y = GetMouseY() / render_scale;
-			size_t wire_id = get_wire_from_pixel(&widget, mouse_x, mouse_y);
+			size_t wire_id = get_wire_from_pixel(widget, mouse_x, mouse_y);
 			if(wire_id != (size_t)-1){
 				printf("wire id: %ld\n", wire_id);
-				wire_t* wire = hda_get_reference(&widget.wires, wire_id);
-				if(wire->touchable) wire->state = !wire->state;
+				for(size_t p = 0; p < pins_count(&widget->pins); p++){
+					if(pins_ref(&widget->pins, p)->wire_id == wire_id) printf("pin: %s\n", pins_ref(&widget->pins, p)->name);
+				}
+				if(hbs_test(&widget->touchable, wire_id)) hbs_toggle(&widget->state, wire_id);
+			}
+		}
+		if(!editing && IsMouseButtonPressed(1)){
+			size_t wire_id = get_wire_from_pixel(widget, GetMouseX() / render_scale, GetMouseY() / render_scale);
+			if(wire_id != (size_t)-1){
+				bitwid_toggle_probe(widget, wire_id);
+				SetWindowSize(widget->image.width * render_scale, 
+							  widget->image.height * render_scale + probes_count(&widget->probes) * BITWID_PROBE_HEIGHT);
 			}
 		}
+		// Step through the history, shift for 64 ticks, enter goes back live
+		if(IsKeyPressed(KEY_LEFT) || IsKeyPressed(KEY_RIGHT)){
+			uint64_t from = widget->history->viewing ? widget->history->view_tick : widget->tick;
+			uint64_t step = IsKeyDown(KEY_LEFT_SHIFT) ? 64 : 1;
+			uint64_t to = IsKeyPressed(KEY_LEFT) ? (from > step ? from - step : 0) : from + step;
+			if(bitwid_view_tick(widget, to)) printf("[BITWIDGETS] Viewing tick %llu\n", (unsigned long long)to);
+		}
+		if(IsKeyPressed(KEY_ENTER)) bitwid_view_tick(widget, widget->tick);
+		// Zoom the probe strips in and out
+		if(IsKeyPressed(KEY_UP) && widget->probe_span > 64) widget->probe_span >>= 1;
+		if(IsKeyPressed(KEY_DOWN) && widget->probe_span < BITWID_PROBE_TICKS) widget->probe_span <<= 1;
+		#ifdef BITWID_ACTIVITY
+		if(IsKeyPressed(KEY_H)) widget->show_heatmap = !widget->show_heatmap;
+		#endif
 		
 		//---------------------------------------------------------------------
 		// Simulation Steps
 		static long sim_accumulator = 0;
 		double start_time = GetTime();
-		while(sim_accumulator < GetTime() * simulation_rate){
-			bitwid_simulate(&widget, 1);
+		if(widget->break_hit != (size_t)-1){
+			// Paused at a breakpoint, space goes on from here
+			sim_accumulator = GetTime() * simulation_rate;
+			if(IsKeyPressed(KEY_SPACE)) widget->break_hit = -1;
+		}
+		if(widget->history->viewing) sim_accumulator = GetTime() * simulation_rate;
+		while(widget->break_hit == (size_t)-1 && !widget->history->viewing && sim_accumulator < GetTime() * simulation_rate){
+			bitwid_simulate(widget, 1);
+			if(widget->break_hit != (size_t)-1) bitwid_report_break(widget);
 			sim_accumulator++;
 			if(GetTime() - start_time > 1.0){
 				break;
 			}
 		}
+		flush_watch_log(widget);
 		// Report Performance
 		static double last_report_time = 0;
 		if(GetTime() - last_report_time >= 0.1f){
 			printf("[BITWIDGETS] FPS: %d| Gates: %ld | Wires: %ld | simulation_rate: %d\n" , 
-						GetFPS(),  hda_get_item_fill(&widget.gates), hda_get_item_fill(&widget.wires), simulation_rate);
+						GetFPS(),  hda_get_item_fill(&widget->gates), hda_get_item_fill(&widget->wires), simulation_rate);
 			last_report_time = GetTime();
 			// Adjust Simulation Rate
 			if(adjust_simrate){
@@ -189,7 +808,8 @@ int main(int argc, char**argv){
 		BeginDrawing();
 		//...
 		ClearBackground((Color){0, 0, 0, 0});
-		bitwid_render_screen(&widget, 0, 0, render_scale);
+		bitwid_render_screen(widget, 0, 0, render_scale);
+		bitwid_render_probes(widget, 0, widget->image.height * render_scale, widget->image.width * render_scale);
 			
 		//---------------------------------------------------------------------
 		EndDrawing();
@@ -197,181 +817,455 @@ int main(int argc, char**argv){
 
 	//---------------------------------------------------------------------------
 	CloseWindow();
-	bitwid_deinit(&widget);
+	loader_stop(loader);
+	if(save_file) bitwid_save_state(widget, save_file);
+	if(export_file) bitwid_export_image(widget, export_file);
+	#ifdef BITWID_ACTIVITY
+	if(activity_top) bitwid_dump_activity(widget, activity_top);
+	#endif
+	bitwid_deinit(widget);
+	free(widget);
 	hap_deinit(argpar);
 	return 0;
 }
 
 //-----------------------------------------------------------------------------
-static void extract_gates(bit_widget_t* widget){
-	Image img = ImageCopy(widget->image);
-	// Find Gates
+static double get_monotonic_time(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+//-----------------------------------------------------------------------------
+// Prints buffered samples, each one is a tick followed by its state words
+static void flush_samples(hh_darray_t* samples){
+	uint64_t* words = hda_to_contiguous(samples);
+	size_t count = hda_get_item_fill(samples);
+	for(size_t i = 0; i < count;){
+		printf("%llu", (unsigned long long)words[i]);
+		size_t word_count = words[i+1];
+		for(size_t w = 0; w < word_count; w++) printf(" %016llx", (unsigned long long)words[i+2+w]);
+		printf("\n");
+		i += 2 + word_count;
+	}
+	hda_clear(samples);
+}
+//-----------------------------------------------------------------------------
+// Simulates ticks steps from the current tick as fast as possible without a
+// window and reports the throughput.
+// With sample_every set, the wire states are buffered every that many steps
+// and printed in batches as: <tick> <state words in hex, wire 0 first>
+// Watched pins are printed once at the start and then on every change.
+static int run_headless(bit_widget_t* widget, uint64_t ticks, uint64_t sample_every){
+	hh_darray_t samples; hda_init(&samples, sizeof(uint64_t));
+	uint64_t start_tick = widget->tick;
+	uint64_t end_tick = start_tick + ticks;
+	// Values of the watched pins before the first step
+	if(hda_get_item_fill(&widget->watches)){
+		printf("%llu", (unsigned long long)widget->tick);
+		for(size_t w = 0; w < pin_ids_count(&widget->watches); w++){
+			uint32_t pin = pin_ids_get(&widget->watches, w);
+			printf(" %s=%d", pins_ref(&widget->pins, pin)->name, bitwid_get_pin(widget, pin));
+		}
+		printf("\n");
+	}
+	double start_time = get_monotonic_time();
+	while(widget->tick < end_tick){
+		uint64_t batch = end_tick - widget->tick;
+		if(batch > BITWID_HEADLESS_BATCH) batch = BITWID_HEADLESS_BATCH;
+		if(sample_every){
+			uint64_t until_sample = sample_every - widget->tick % sample_every;
+			if(batch > until_sample) batch = until_sample;
+		}
+		bitwid_simulate(widget, batch);
+		flush_watch_log(widget);
+		if(widget->break_hit != (size_t)-1){
+			bitwid_report_break(widget);
+			break;
+		}
+		if(sample_every && widget->tick % sample_every == 0){
+			hda_append(&samples, &widget->tick);
+			hda_append(&samples, &widget->state.words);
+			hda_append_n(&samples, widget->state.data, widget->state.words);
+			if(hda_get_item_fill(&samples) >= BITWID_SAMPLE_FLUSH) flush_samples(&samples);
+		}
+	}
+	double elapsed = get_monotonic_time() - start_time;
+	flush_samples(&samples);
+	hda_deinit(&samples);
+	uint64_t simulated = widget->tick - start_tick;
+	printf("[BITWIDGETS] Simulated %llu ticks in %.3f s (%.0f ticks/s) | Gates: %zu | Wires: %zu\n", 
+			(unsigned long long)simulated, elapsed, elapsed > 0 ? simulated / elapsed : 0.0, 
+			gates_count(&widget->gates), wires_count(&widget->wires));
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// The image path, 0 if missing. hap_get_positional takes the argument after
+// every option as its value, so the options without one are skipped here
+static char* get_circuit_path(hh_argparse_t* argpar){
+	const char* flags[] = {"-H", "--headless", "-a", "--adjust-simrate", "-h", "--help"};
+	for(int i = 1; i < argpar->argc; i++){
+		char* arg = argpar->argv[i];
+		if(arg[0] != '-') return arg;
+		bool has_value = true;
+		for(size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++){
+			if(strcmp(arg, flags[f]) == 0) has_value = false;
+		}
+		if(has_value) i++;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Applies the pin, stimulus, set and watch options to a loaded widget
+static int setup_widget(bit_widget_t* widget, hh_argparse_t* argpar){
+	if(hap_check_op_short_or_long(argpar, 'p', "pins")){
+		if(bitwid_load_pins(widget, hap_get_op_short_or_long(argpar, 'p', "pins")) != 0) return -1;
+	}
+	if(hap_check_op_short_or_long(argpar, 'L', "load-state")){
+		if(bitwid_load_state(widget, hap_get_op_short_or_long(argpar, 'L', "load-state")) != 0) return -1;
+	}
+	if(hap_check_op_short_or_long(argpar, 'i', "stimulus")){
+		if(bitwid_load_stimulus(widget, hap_get_op_short_or_long(argpar, 'i', "stimulus")) != 0) return -1;
+	}
+	char* option;
+	for(int n = 0; (option = hap_get_nth_op_short_or_long(argpar, 'v', "set", n)); n++){
+		char name[BITWID_PIN_NAME];
+		int value, length = 0;
+		if(sscanf(option, "%31[A-Za-z0-9_]=%d%n", name, &value, &length) != 2 || option[length] != 0 || 
+		   (value != 0 && value != 1)){
+			printf("Error: --set expects <pin>=<0|1>, got %s\n", option);
+			return -1;
+		}
+		size_t pin = bitwid_find_pin(widget, name);
+		if(pin == (size_t)-1){
+			printf("Error: No pin named %s\n", name);
+			return -1;
+		}
+		if(!pins_ref(&widget->pins, pin)->input) printf("Warning: pin %s is driven by a gate\n", name);
+		bitwid_set_pin(widget, pin, value);
+		// Not a change of the first step
+		hbs_assign(&widget->last_state, pins_ref(&widget->pins, pin)->wire_id, value);
+	}
+	for(int n = 0; (option = hap_get_nth_op_short_or_long(argpar, 'w', "watch", n)); n++){
+		size_t pin = bitwid_find_pin(widget, option);
+		if(pin == (size_t)-1){
+			printf("Error: No pin named %s\n", option);
+			return -1;
+		}
+		bitwid_watch_pin(widget, pin);
+	}
+	for(int n = 0; (option = hap_get_nth_op_short_or_long(argpar, 'b', "break", n)); n++){
+		if(bitwid_add_breakpoint(widget, option) != 0) return -1;
+	}
+	if(hap_check_op_short_or_long(argpar, 'R', "record")){
+		uint64_t ring_ticks = 0;
+		if(hap_check_op_short_or_long(argpar, 'N', "record-ring")){
+			ring_ticks = strtoull(hap_get_op_short_or_long(argpar, 'N', "record-ring"), 0, 10);
+		}
+		if(recorder_start(widget, hap_get_op_short_or_long(argpar, 'R', "record"), ring_ticks) != 0) return -1;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Prints the logged pin changes as: <tick> <pin>=<0|1>
+static void flush_watch_log(bit_widget_t* widget){
+	for(size_t i = 0; i < watch_events_count(&widget->watch_log); i++){
+		watch_event_t* event = watch_events_ref(&widget->watch_log, i);
+		printf("%llu %s=%d\n", (unsigned long long)event->tick, 
+			   pins_ref(&widget->pins, event->pin)->name, event->value);
+	}
+	hda_clear(&widget->watch_log);
+}
+//-----------------------------------------------------------------------------
+// Counts gates exactly and gives an upper bound of wires as the number of
+// horizontal runs of wire colored pixels with no pixel of the same color
+// right above them. The topmost run of every wire is one of those.
+static void count_gates_and_wires(bit_widget_t* widget, size_t* gate_count, size_t* wire_bound){
+	Image img = widget->image;
+	*gate_count = 0;
+	*wire_bound = 0;
 	for(size_t y = 0; y < (unsigned int)img.height; y++){
-		for(size_t x = 0; x < (unsigned int)img.width; x++){
+		wire_color_e left = SPACE;
+		bool linked = false; // Run on the left touches its color above
+		for(size_t x = 0; x <= (unsigned int)img.width; x++){
+			if(x == (unsigned int)img.width){
+				if(left != SPACE && !linked) (*wire_bound)++;
+				break;
+			}
 			Color color = GetImageColor(img, x, y);
 			if(ColorToInt(color) == (int)GATE_INPUT){
 				for(int n = 0; n < 4; n++){
-					Color n_color = GetImageColor(img, x + direction_x[n], 
-													   y + direction_y[n]);
-					if(ColorToInt(n_color) == (int)NOT_GATE){
-						hda_append(&widget->gates, 0);
-						gate_t* new_gate = hda_get_end_reference(&widget->gates);
-						new_gate->x = x; 
-						new_gate->y = y;
-						new_gate->type = NOT_GATE;
-						new_gate->direction = n;
-					}
-					if(ColorToInt(n_color) == (int)DIODE){
-						hda_append(&widget->gates, 0);
-						gate_t* new_gate = hda_get_end_reference(&widget->gates);
-						new_gate->x = x; 
-						new_gate->y = y;
-						new_gate->type = DIODE;
-						new_gate->direction = n;
-					}
-					
+					int n_color = ColorToInt(GetImageColor(img, x + direction_x[n], y + direction_y[n]));
+					if(n_color == (int)NOT_GATE || n_color == (int)DIODE) (*gate_count)++;
 				}
+			}
+			wire_color_e wire_color = get_wire_color(color);
+			if(wire_color == WIRE_CROSSING) wire_color = SPACE;
+			if(wire_color != left){
+				if(left != SPACE && !linked) (*wire_bound)++;
+				linked = false;
+			}
+			if(wire_color != SPACE && y > 0){
+				linked |= get_wire_color(GetImageColor(img, x, y - 1)) == wire_color;
+			}
+			left = wire_color;
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+typedef struct{
+	Image image;
+	hh_darray_t* gates; // Shard this worker appends to
+	size_t y_start, y_end; // Band of rows it scans
+}gate_worker_t;
+
+//-----------------------------------------------------------------------------
+static size_t get_worker_count(size_t rows){
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t count = rows / BITWID_ROWS_PER_WORKER;
+	if(cpus > 0 && count > (size_t)cpus) count = cpus;
+	if(count > BITWID_MAX_WORKERS) count = BITWID_MAX_WORKERS;
+	return count ? count : 1;
+}
 
-			}	
+//-----------------------------------------------------------------------------
+// Scans the image in bands of rows, one thread per band. Gates of a band go
+// to its own shard, merged in band order so gate ids match a serial scan.
+static void extract_gates(bit_widget_t* widget){
+	size_t rows = widget->image.height;
+	size_t worker_count = get_worker_count(rows);
+	hh_darray_shards_t shards; hda_shards_init(&shards, sizeof(gate_t), worker_count);
+	gate_worker_t workers[BITWID_MAX_WORKERS];
+	pthread_t threads[BITWID_MAX_WORKERS];
+	bool started[BITWID_MAX_WORKERS] = {0};
+	for(size_t i = 0; i < worker_count; i++){
+		workers[i] = (gate_worker_t){widget->image, hda_shards_get(&shards, i), 
+									 rows * i / worker_count, rows * (i+1) / worker_count};
+		if(i > 0) started[i] = pthread_create(&threads[i], 0, extract_gates_worker, &workers[i]) == 0;
+	}
+	// Bands whose thread could not start are scanned here
+	for(size_t i = 0; i < worker_count; i++){
+		if(!started[i]) extract_gates_worker(&workers[i]);
+	}
+	for(size_t i = 1; i < worker_count; i++){
+		if(started[i]) pthread_join(threads[i], 0);
+	}
+	hda_shards_merge(&shards, &widget->gates);
+	hda_shards_deinit(&shards);
+	hbm_init(&widget->gate_map, widget->image.width, widget->image.height);
+	for(size_t i = 0; i < gates_count(&widget->gates); i++) mark_gate(widget, gates_ref(&widget->gates, i));
+}
+//-----------------------------------------------------------------------------
+static void mark_gate(bit_widget_t* widget, gate_t* gate){
+	hbm_set(&widget->gate_map, gate->x, gate->y);
+	hbm_set(&widget->gate_map, gate->x + direction_x[gate->direction], gate->y + direction_y[gate->direction]);
+}
+//-----------------------------------------------------------------------------
+static void* extract_gates_worker(void* arg){
+	gate_worker_t* worker = arg;
+	Image img = worker->image;
+	// Find Gates
+	for(size_t y = worker->y_start; y < worker->y_end; y++){
+		for(size_t x = 0; x < (unsigned int)img.width; x++){
+			find_gates_at(img, x, y, worker->gates);
 		}
 	}
-	UnloadImage(img);
+	return 0;
 }
 //-----------------------------------------------------------------------------
-void extract_wires(bit_widget_t* widget){
-	Image img = ImageCopy(widget->image);
-	// Remove Gates
-	for(size_t i = 0; i < hda_get_item_fill(&widget->gates); i++){
-		gate_t* gate = hda_get_reference(&widget->gates, i);
-		ImageDrawPixel(&img, gate->x, gate->y, (Color){0, 0, 0, 0});
-		ImageDrawPixel(&img, gate->x + direction_x[gate->direction], 
-							gate->y + direction_y[gate->direction], 
-							(Color){0, 0, 0, 0});
+// Adds a gate for every gate pixel next to a gate input at x, y
+static void find_gates_at(Image img, size_t x, size_t y, hh_darray_t* gates){
+	if(x >= (unsigned int)img.width || y >= (unsigned int)img.height) return;
+	Color color = GetImageColor(img, x, y);
+	if(ColorToInt(color) != (int)GATE_INPUT) return;
+	for(int n = 0; n < 4; n++){
+		Color n_color = GetImageColor(img, x + direction_x[n], 
+										   y + direction_y[n]);
+		if(ColorToInt(n_color) == (int)NOT_GATE){
+			gates_push(gates, (gate_t){.x = x, .y = y, 
+						.type = NOT_GATE, .direction = n});
+		}
+		if(ColorToInt(n_color) == (int)DIODE){
+			gates_push(gates, (gate_t){.x = x, .y = y, 
+						.type = DIODE, .direction = n});
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+// Lists the crossing once, flood fills reach it from every side
+static void add_crossing(bit_widget_t* widget, size_t x, size_t y){
+	if(hbm_test(&widget->crossing_map, x, y)) return;
+	hbm_set(&widget->crossing_map, x, y);
+	pixels_push(&widget->crossings, (pixel_t){x, y});
+}
+//-----------------------------------------------------------------------------
+// Unlists a crossing that an edit cut off
+static void remove_crossing(bit_widget_t* widget, size_t x, size_t y){
+	hbm_clear(&widget->crossing_map, x, y);
+	size_t last = pixels_count(&widget->crossings) - 1;
+	for(size_t i = 0; i <= last; i++){
+		pixel_t pix = pixels_get(&widget->crossings, i);
+		if(pix.x != x || pix.y != y) continue;
+		*pixels_ref(&widget->crossings, i) = pixels_get(&widget->crossings, last);
+		hda_popend(&widget->crossings, 0);
+		return;
 	}
+}
+//-----------------------------------------------------------------------------
+// Adds the pixel to the flood fill queue if its not already waiting in it
+static int enqueue_pixel(hh_deque_t* queue, hh_hashset_t* queued, size_t* pixel){
+	if(!hhs_insert(queued, pixel)) return 0;
+	hdq_push_back(queue, pixel);
+	return 1;
+}
+//-----------------------------------------------------------------------------
+// Wire color of the pixel, visited or out of image pixels read as SPACE
+static wire_color_e get_unvisited_wire_color(bit_widget_t* widget, hh_bitmap_t* visited, size_t x, size_t y){
+	if(x >= (unsigned int)widget->image.width || y >= (unsigned int)widget->image.height) return SPACE;
+	if(hbm_test(visited, x, y)) return SPACE;
+	return get_wire_color(GetImageColor(widget->image, x, y));
+}
+//-----------------------------------------------------------------------------
+void extract_wires(bit_widget_t* widget){
+	Image img = widget->image;
+	// Gate pixels are never part of a wire
+	hh_bitmap_t visited; hbm_init(&visited, img.width, img.height);
+	memcpy(visited.data, widget->gate_map.data, visited.stride * visited.height * sizeof(uint64_t));
 	// Find Wires
 	for(size_t y = 0; y < (unsigned int)img.height; y++){
+		report_load_fraction(widget, (float)y / img.height);
 		for(size_t x = 0; x < (unsigned int)img.width; x++){
-			Color color = GetImageColor(img, x, y);
-			wire_color_e temp_color = get_wire_color(color);
+			wire_color_e temp_color = get_unvisited_wire_color(widget, &visited, x, y);
 			if(temp_color == SPACE) continue;	
 			if(temp_color == WIRE_CROSSING) continue;	
 			//...
-			hda_append(&widget->wires, 0);
-			wire_t* new_wire = hda_get_end_reference(&widget->wires);
-			hda_init(&new_wire->pixels, sizeof(size_t)*2);
-			new_wire->color = temp_color;
-			new_wire->state = get_wire_state(color);
-			new_wire->touchable = true;
-			// Flood fill wire
-			hh_darray_t checker; hda_init(&checker, sizeof(size_t)*2);
-			hh_darray_t skipper; hda_init(&skipper, 1);
-			hda_append(&checker, (size_t[]){x, y});
-			hda_append(&skipper, 0);
-			bool skip_val = 1;					
-			while(0 < hda_get_item_fill(&checker)){
-				struct {size_t x; size_t y;} pix;
-				bool skip;
-				hda_pop(&checker, 0, &pix);
-				hda_pop(&skipper, 0, &skip);
-				if(!skip){
-					hda_append(&new_wire->pixels, &pix);
-					ImageDrawPixel(&img, pix.x, pix.y, (Color){0, 0, 0, 0});
+			wires_push(&widget->wires, (wire_t){0});
+			pixels_init_with(&wires_end(&widget->wires)->pixels, &widget->allocator);
+			#ifdef HH_DARRAY_STATS
+			hda_set_stats(&wires_end(&widget->wires)->pixels, &widget->pixel_stats);
+			#endif
+			flood_wire(widget, &visited, x, y, wires_count(&widget->wires) - 1);
+		}
+	}
+	hbm_deinit(&visited);
+}
+//-----------------------------------------------------------------------------
+// Fills the wire with every unvisited pixel connected to x, y and marks them
+// visited. Wires go on past crossings, and through gate pixels to pixels of
+// the same color on their other sides.
+static void flood_wire(bit_widget_t* widget, hh_bitmap_t* visited, size_t x, size_t y, uint32_t wire_id){
+	Image img = widget->image;
+	wire_t* new_wire = wires_ref(&widget->wires, wire_id);
+	new_wire->color = get_wire_color(GetImageColor(img, x, y));
+	hh_deque_t checker; hdq_init(&checker, sizeof(size_t)*2);
+	hh_deque_t skipper; hdq_init(&skipper, 1);
+	hh_hashset_t queued; hhs_init(&queued, sizeof(size_t)*2);
+	enqueue_pixel(&checker, &queued, (size_t[]){x, y});
+	hdq_push_back(&skipper, 0);
+	bool skip_val = 1;					
+	while(0 < hdq_get_item_fill(&checker)){
+		pixel_t pix;
+		bool skip;
+		hdq_pop_front(&checker, &pix);
+		hhs_remove(&queued, &pix);
+		hdq_pop_front(&skipper, &skip);
+		if(!skip){
+			pixels_push(&new_wire->pixels, pix);
+			hbm_set(visited, pix.x, pix.y);
+			widget->wire_plane[pix.y * img.width + pix.x] = wire_id;
+		}
+		// Check neighbors
+		if(pix.x < (unsigned int)img.width-1){
+			if(get_unvisited_wire_color(widget, visited, pix.x + 1, pix.y) == new_wire->color){
+				if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x + 1, pix.y})){
+					hdq_push_back(&skipper, 0);
 				}
-				// Check neighbors
-				if(pix.x < (unsigned int)img.width-1){
-					if(get_wire_color(GetImageColor(img, pix.x + 1, pix.y)) == new_wire->color){
-						if(hda_append_no_dupe(&checker, (size_t[]){pix.x + 1, pix.y})){
-							hda_append(&skipper, 0);
+			}
+			if(!skip){
+				if(get_unvisited_wire_color(widget, visited, pix.x + 1, pix.y) == WIRE_CROSSING){	
+					add_crossing(widget, pix.x + 1, pix.y);
+					if(get_unvisited_wire_color(widget, visited, pix.x + 2, pix.y) == new_wire->color){
+						if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x + 2, pix.y})){
+							hdq_push_back(&skipper, 0);
 						}
 					}
-					if(!skip){
-						if(get_wire_color(GetImageColor(img, pix.x + 1, pix.y)) == WIRE_CROSSING){	
-							hda_append(&widget->crossings, (size_t[]){pix.x + 1, pix.y});
-							if(get_wire_color(GetImageColor(img, pix.x + 2, pix.y)) == new_wire->color){
-								if(hda_append_no_dupe(&checker, (size_t[]){pix.x + 2, pix.y})){
-									hda_append(&skipper, 0);
-								}
-							}
-						}
-						if(get_gate_from_pixel(widget, pix.x + 1, pix.y) != (size_t)-1){
-							if(hda_append_no_dupe(&checker, (size_t[]){pix.x + 1, pix.y})){
-								hda_append(&skipper, &skip_val);						
-							}
-						}
+				}
+				if(hbm_test(&widget->gate_map, pix.x + 1, pix.y)){
+					if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x + 1, pix.y})){
+						hdq_push_back(&skipper, &skip_val);						
 					}
 				}
-				if(pix.x > 0){
-					if(get_wire_color(GetImageColor(img, pix.x - 1, pix.y)) == new_wire->color){
-						if(hda_append_no_dupe(&checker, (size_t[]){pix.x - 1, pix.y})){
-							hda_append(&skipper, 0);
+			}
+		}
+		if(pix.x > 0){
+			if(get_unvisited_wire_color(widget, visited, pix.x - 1, pix.y) == new_wire->color){
+				if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x - 1, pix.y})){
+					hdq_push_back(&skipper, 0);
+				}
+			}
+			if(!skip){
+				if(get_unvisited_wire_color(widget, visited, pix.x - 1, pix.y) == WIRE_CROSSING){	
+					add_crossing(widget, pix.x - 1, pix.y);
+					if(get_unvisited_wire_color(widget, visited, pix.x - 2, pix.y) == new_wire->color){
+						if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x - 2, pix.y})){
+							hdq_push_back(&skipper, 0);
 						}
 					}
-					if(!skip){
-						if(get_wire_color(GetImageColor(img, pix.x - 1, pix.y)) == WIRE_CROSSING){	
-							hda_append(&widget->crossings, (size_t[]){pix.x - 1, pix.y});
-							if(get_wire_color(GetImageColor(img, pix.x - 2, pix.y)) == new_wire->color){
-								if(hda_append_no_dupe(&checker, (size_t[]){pix.x - 2, pix.y})){
-									hda_append(&skipper, 0);
-								}
-							}
-						}
-						if(get_gate_from_pixel(widget, pix.x - 1, pix.y) != (size_t)-1){
-							if(hda_append_no_dupe(&checker, (size_t[]){pix.x - 1, pix.y})){
-								hda_append(&skipper, &skip_val);						
-							}
-						}
+				}
+				if(hbm_test(&widget->gate_map, pix.x - 1, pix.y)){
+					if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x - 1, pix.y})){
+						hdq_push_back(&skipper, &skip_val);						
 					}
 				}
-				if(pix.y < (unsigned int)img.height-1){
-					if(get_wire_color(GetImageColor(img, pix.x, pix.y + 1)) == new_wire->color){
-						if(hda_append_no_dupe(&checker, (size_t[]){pix.x, pix.y + 1})){
-							hda_append(&skipper, 0);
+			}
+		}
+		if(pix.y < (unsigned int)img.height-1){
+			if(get_unvisited_wire_color(widget, visited, pix.x, pix.y + 1) == new_wire->color){
+				if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x, pix.y + 1})){
+					hdq_push_back(&skipper, 0);
+				}
+			}
+			if(!skip){
+				if(get_unvisited_wire_color(widget, visited, pix.x, pix.y + 1) == WIRE_CROSSING){	
+					add_crossing(widget, pix.x, pix.y + 1);
+					if(get_unvisited_wire_color(widget, visited, pix.x, pix.y + 2) == new_wire->color){
+						if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x, pix.y + 2})){
+							hdq_push_back(&skipper, 0);
 						}
 					}
-					if(!skip){
-						if(get_wire_color(GetImageColor(img, pix.x, pix.y + 1)) == WIRE_CROSSING){	
-							hda_append(&widget->crossings, (size_t[]){pix.x, pix.y + 1});
-							if(get_wire_color(GetImageColor(img, pix.x, pix.y + 2)) == new_wire->color){
-								if(hda_append_no_dupe(&checker, (size_t[]){pix.x, pix.y + 2})){
-									hda_append(&skipper, 0);
-								}
-							}
-						}
-						if(get_gate_from_pixel(widget, pix.x, pix.y + 1) != (size_t)-1){
-							if(hda_append_no_dupe(&checker, (size_t[]){pix.x, pix.y + 1})){
-								hda_append(&skipper, &skip_val);						
-							}
-						}
+				}
+				if(hbm_test(&widget->gate_map, pix.x, pix.y + 1)){
+					if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x, pix.y + 1})){
+						hdq_push_back(&skipper, &skip_val);						
 					}
 				}
-				if(pix.y > 0){
-					if(get_wire_color(GetImageColor(img, pix.x, pix.y - 1)) == new_wire->color){
-						if(hda_append_no_dupe(&checker, (size_t[]){pix.x, pix.y - 1})){
-							hda_append(&skipper, 0);
+			}
+		}
+		if(pix.y > 0){
+			if(get_unvisited_wire_color(widget, visited, pix.x, pix.y - 1) == new_wire->color){
+				if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x, pix.y - 1})){
+					hdq_push_back(&skipper, 0);
+				}
+			}
+			if(!skip){
+				if(get_unvisited_wire_color(widget, visited, pix.x, pix.y - 1) == WIRE_CROSSING){
+					add_crossing(widget, pix.x, pix.y - 1);	
+					if(get_unvisited_wire_color(widget, visited, pix.x, pix.y - 2) == new_wire->color){
+						if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x, pix.y - 2})){
+							hdq_push_back(&skipper, 0);
 						}
 					}
-					if(!skip){
-						if(get_wire_color(GetImageColor(img, pix.x, pix.y - 1)) == WIRE_CROSSING){
-							hda_append(&widget->crossings, (size_t[]){pix.x, pix.y - 1});	
-							if(get_wire_color(GetImageColor(img, pix.x, pix.y - 2)) == new_wire->color){
-								if(hda_append_no_dupe(&checker, (size_t[]){pix.x, pix.y - 2})){
-									hda_append(&skipper, 0);
-								}
-							}
-						}
-						if(get_gate_from_pixel(widget, pix.x, pix.y - 1) != (size_t)-1){
-							if(hda_append_no_dupe(&checker, (size_t[]){pix.x, pix.y - 1})){
-								hda_append(&skipper, &skip_val);						
-							}
-						}
+				}
+				if(hbm_test(&widget->gate_map, pix.x, pix.y - 1)){
+					if(enqueue_pixel(&checker, &queued, (size_t[]){pix.x, pix.y - 1})){
+						hdq_push_back(&skipper, &skip_val);						
 					}
 				}
 			}
-			hda_deinit(&checker);
-			hda_deinit(&skipper);
 		}
 	}
-	UnloadImage(img);
+	hdq_deinit(&checker);
+	hdq_deinit(&skipper);
+	hhs_deinit(&queued);
 }
 
 //-----------------------------------------------------------------------------
@@ -405,90 +1299,210 @@ Color lower_color(Color color){
 
 //-----------------------------------------------------------------------------
 void attack_gate_to_wires(bit_widget_t* widget){
-	for(size_t i = 0; i < hda_get_item_fill(&widget->gates); i++){
-		gate_t* gate = hda_get_reference(&widget->gates, i);
-		for(int d = 0; d < 4; d++){
-			size_t input_id = get_wire_from_pixel(widget, gate->x + direction_x[d], gate->y + direction_y[d]);
-			if(input_id != (size_t)-1){
-				gate->input_wire_id = input_id;
-				break;
-			}
+	for(size_t i = 0; i < gates_count(&widget->gates); i++){
+		attach_gate(widget, gates_ref(&widget->gates, i));
+	}
+}
+//-----------------------------------------------------------------------------
+// Connects the gate to the first wire found around its input and output
+static void attach_gate(bit_widget_t* widget, gate_t* gate){
+	for(int d = 0; d < 4; d++){
+		size_t input_id = get_wire_from_pixel(widget, gate->x + direction_x[d], gate->y + direction_y[d]);
+		if(input_id != (size_t)-1){
+			gate->input_wire_id = input_id;
+			break;
 		}
-		for(int d = 0; d < 4; d++){
-			size_t output_id = get_wire_from_pixel(widget, gate->x + direction_x[d] + direction_x[gate->direction], 
-												   gate->y + direction_y[d] + direction_y[gate->direction]);
-			if(output_id != (size_t)-1){
-				wire_t* wire = hda_get_reference(&widget->wires, output_id);
-				wire->touchable = false;
-				gate->output_wire_id = output_id;
-				break;
-			}
+	}
+	for(int d = 0; d < 4; d++){
+		size_t output_id = get_wire_from_pixel(widget, gate->x + direction_x[d] + direction_x[gate->direction], 
+											   gate->y + direction_y[d] + direction_y[gate->direction]);
+		if(output_id != (size_t)-1){
+			hbs_clear(&widget->touchable, output_id);
+			gate->output_wire_id = output_id;
+			break;
 		}
 	}
 }
 
 //-----------------------------------------------------------------------------
-size_t get_wire_from_pixel(bit_widget_t* widget, size_t x, size_t y){
-	for(size_t i = 0; i < hda_get_item_fill(&widget->wires); i++){
-		wire_t* wire = hda_get_reference(&widget->wires, i);
-		for(size_t p = 0; p < hda_get_item_fill(&wire->pixels); p++){
-			struct {size_t x, y;} pix;
-			hda_get(&wire->pixels, p, &pix);
-			if(pix.x == x && pix.y == y) return i;
-		}	
+// Allocates the state bitsets and loads the states drawn in the image
+static void init_wire_states(bit_widget_t* widget){
+	size_t wire_count = wires_count(&widget->wires);
+	hbs_init(&widget->state, wire_count);
+	hbs_init(&widget->last_state, wire_count);
+	hbs_init(&widget->changed, wire_count);
+	hbs_init(&widget->touchable, wire_count);
+	hbs_init(&widget->drive, wire_count);
+	hbs_set_all(&widget->touchable);
+	for(size_t i = 0; i < wire_count; i++){
+		// First pixel of a wire is the one its flood fill started from
+		pixel_t seed = pixels_get(&wires_ref(&widget->wires, i)->pixels, 0);
+		hbs_assign(&widget->state, i, get_wire_state(GetImageColor(widget->image, seed.x, seed.y)));
 	}
-	return -1;
+	hbs_copy(&widget->last_state, &widget->state);
+	#ifdef BITWID_ACTIVITY
+	widget->activity = calloc(wire_count ? wire_count : 1, sizeof(uint64_t));
+	widget->activity_planes = calloc((widget->state.words ? widget->state.words : 1) * BITWID_ACTIVITY_PLANES, sizeof(uint64_t));
+	#endif
 }
 
 //-----------------------------------------------------------------------------
-size_t get_gate_from_pixel(bit_widget_t* widget, size_t x, size_t y){
-	for(size_t i = 0; i < hda_get_item_fill(&widget->gates); i++){
-		gate_t* gate = hda_get_reference(&widget->gates, i);
-		if(gate->x == x && gate->y == y) return i;
-		if(gate->x + direction_x[gate->direction] == x && gate->y + direction_y[gate->direction] == y) return i;
-	}
-	return -1;
+size_t get_wire_from_pixel(bit_widget_t* widget, size_t x, size_t y){
+	if(x >= (unsigned int)widget->image.width || y >= (unsigned int)widget->image.height) return -1;
+	uint32_t wire_id = widget->wire_plane[y * widget->image.width + x];
+	if(wire_id == NO_WIRE) return -1;
+	return wire_id;
 }
 
 //-----------------------------------------------------------------------------
 int bitwid_init(bit_widget_t* widget, char* filename){
-	hda_init(&widget->gates, sizeof(gate_t));
-	hda_init(&widget->wires, sizeof(wire_t));
-	hda_init(&widget->crossings, sizeof(size_t)*2);
+	return bitwid_init_with_progress(widget, filename, 0);
+}
+//-----------------------------------------------------------------------------
+// Same as bitwid_init, reporting every stage to progress if not 0
+int bitwid_init_with_progress(bit_widget_t* widget, char* filename, load_progress_t* progress){
+	widget->progress = progress;
+	report_load_stage(widget, LOAD_IMAGE);
+	hh_arena_init(&widget->arena, 0);
+	widget->allocator = (hh_darray_allocator_t){hh_arena_realloc, hh_arena_free, &widget->arena};
+	gates_init(&widget->gates);
+	wires_init(&widget->wires);
+	pixels_init(&widget->crossings);
+	#ifdef HH_DARRAY_STATS
+	widget->gate_stats = (hh_darray_stats_t){.tag = "gates"};
+	widget->wire_stats = (hh_darray_stats_t){.tag = "wires"};
+	widget->pixel_stats = (hh_darray_stats_t){.tag = "wire pixels"};
+	widget->crossing_stats = (hh_darray_stats_t){.tag = "crossings"};
+	hda_set_stats(&widget->gates, &widget->gate_stats);
+	hda_set_stats(&widget->wires, &widget->wire_stats);
+	hda_set_stats(&widget->crossings, &widget->crossing_stats);
+	#endif
 	widget->image = LoadImage(filename);
 	widget->filename = malloc(strlen(filename)+1);
 	memcpy(widget->filename, filename, strlen(filename)+1);
 	preprocess_image(widget);
+	size_t pixel_count = (size_t)widget->image.width * widget->image.height;
+	widget->wire_plane = malloc(pixel_count * sizeof(uint32_t));
+	hbm_init(&widget->crossing_map, widget->image.width, widget->image.height);
+	memset(widget->wire_plane, 0xFF, pixel_count * sizeof(uint32_t));
+	widget->tick = 0;
+	events_init(&widget->stimulus);
+	widget->stimulus_cursor = 0;
+	widget->recorder = 0;
+	widget->history = 0;
+	probes_init(&widget->probes);
+	breakpoints_init(&widget->breakpoints);
+	widget->break_hit = -1;
+	widget->probe_span = 4096;
+	#ifdef BITWID_ACTIVITY
+	widget->activity_pending = 0;
+	widget->show_heatmap = 0;
+	#endif
+	pins_init(&widget->pins);
+	pin_ids_init(&widget->watches);
+	watch_events_init(&widget->watch_log);
     
-	printf("[BITWIDGETS] Extracting gates...\n");
+	report_load_stage(widget, LOAD_COUNT);
+	size_t gate_count, wire_bound;
+	count_gates_and_wires(widget, &gate_count, &wire_bound);
+	hda_reserve(&widget->gates, gate_count);
+	hda_reserve(&widget->wires, wire_bound);
+	report_load_stage(widget, LOAD_GATES);
 	extract_gates(widget);
 	//...
-	printf("[BITWIDGETS] Extracting Wires...\n");
+	report_load_stage(widget, LOAD_WIRES);
 	extract_wires(widget);
 	//...
-	printf("[BITWIDGETS] Attaching gates and wires...\n");
+	init_wire_states(widget);
+	report_load_stage(widget, LOAD_ATTACH);
 	attack_gate_to_wires(widget);
-	printf("[BITWIDGETS] Ready!\n");
+	// Pin file next to the image is optional
+	char* pin_filename = get_pin_filename(filename);
+	if(access(pin_filename, R_OK) == 0) bitwid_load_pins(widget, pin_filename);
+	free(pin_filename);
+	report_load_stage(widget, LOAD_DONE);
+	widget->progress = 0;
 	//-----------------------------------
 	return 0;
 }
 //-----------------------------------------------------------------------------
+static void report_load_stage(bit_widget_t* widget, load_stage_e stage){
+	printf("[BITWIDGETS] %s\n", load_stage_names[stage]);
+	if(!widget->progress) return;
+	pthread_mutex_lock(&widget->progress->lock);
+	widget->progress->stage = stage;
+	widget->progress->fraction = 0;
+	pthread_mutex_unlock(&widget->progress->lock);
+}
+//-----------------------------------------------------------------------------
+static void report_load_fraction(bit_widget_t* widget, float fraction){
+	if(!widget->progress) return;
+	pthread_mutex_lock(&widget->progress->lock);
+	widget->progress->fraction = fraction;
+	pthread_mutex_unlock(&widget->progress->lock);
+}
+//-----------------------------------------------------------------------------
+// Part of the whole load done, 0 to 1, every stage counting the same
+float get_load_progress(load_progress_t* progress, load_stage_e* stage){
+	pthread_mutex_lock(&progress->lock);
+	*stage = progress->stage;
+	float done = (progress->stage + progress->fraction) / LOAD_DONE;
+	pthread_mutex_unlock(&progress->lock);
+	return done;
+}
+//-----------------------------------------------------------------------------
+static void* init_worker(void* arg){
+	init_worker_t* worker = arg;
+	bitwid_init_with_progress(worker->widget, worker->filename, &worker->progress);
+	return 0;
+}
+//-----------------------------------------------------------------------------
 void bitwid_deinit(bit_widget_t* widget){
+	if(widget->recorder) recorder_stop(widget);
+	if(widget->history) bitwid_disable_history(widget);
+	while(probes_count(&widget->probes)) bitwid_toggle_probe(widget, probes_ref(&widget->probes, 0)->wire_id);
+	hda_deinit(&widget->probes);
+	for(size_t i = 0; i < breakpoints_count(&widget->breakpoints); i++){
+		hda_deinit(&breakpoints_ref(&widget->breakpoints, i)->terms);
+		hda_deinit(&breakpoints_ref(&widget->breakpoints, i)->triggers);
+	}
+	hda_deinit(&widget->breakpoints);
 	UnloadImage(widget->image);
 	free(widget->filename);
-	hda_deinit(&widget->gates);
-	for(size_t i = 0; i < hda_get_item_fill(&widget->wires); i++){
-		wire_t* wire = hda_get_reference(&widget->wires, i);
-		hda_deinit(&wire->pixels);
-	}
+	free(widget->wire_plane);
+	hbm_deinit(&widget->gate_map);
+	hbm_deinit(&widget->crossing_map);
+	#ifdef HH_DARRAY_STATS
+	hda_dump_stats(&widget->gate_stats, stdout);
+	hda_dump_stats(&widget->wire_stats, stdout);
+	hda_dump_stats(&widget->pixel_stats, stdout);
+	hda_dump_stats(&widget->crossing_stats, stdout);
+	hda_dump_stats(&hh_darray_untagged_stats, stdout);
+	#endif
+	for(size_t i = 0; i < wires_count(&widget->wires); i++) hda_deinit(&wires_ref(&widget->wires, i)->pixels);
+	hh_arena_deinit(&widget->arena);
 	hda_deinit(&widget->wires);
+	hda_deinit(&widget->gates);
 	hda_deinit(&widget->crossings);
+	hda_deinit(&widget->stimulus);
+	hda_deinit(&widget->pins);
+	hda_deinit(&widget->watches);
+	hda_deinit(&widget->watch_log);
+	hbs_deinit(&widget->state);
+	hbs_deinit(&widget->last_state);
+	hbs_deinit(&widget->changed);
+	hbs_deinit(&widget->touchable);
+	hbs_deinit(&widget->drive);
+	#ifdef BITWID_ACTIVITY
+	free(widget->activity);
+	free(widget->activity_planes);
+	#endif
 }
 //-----------------------------------------------------------------------------
 void bitwid_render_screen(bit_widget_t* widget, int x, int y, int scale){
 	// Draw Gates
-	for(size_t i = 0; i < hda_get_item_fill(&widget->gates); i++){
-		gate_t* gate = hda_get_reference(&widget->gates, i);
+	for(size_t i = 0; i < gates_count(&widget->gates); i++){
+		gate_t* gate = gates_ref(&widget->gates, i);
 		DrawRectangle(gate->x*scale + x, gate->y*scale + y, 
 						scale, scale, GetColor(GATE_INPUT));
 		DrawRectangle((gate->x + direction_x[gate->direction])*scale + x, 
@@ -497,12 +1511,33 @@ void bitwid_render_screen(bit_widget_t* widget, int x, int y, int scale){
 	}
 
 	// Draw Wires
-	for(size_t i = 0; i < hda_get_item_fill(&widget->wires); i++){
-		wire_t* wire = hda_get_reference(&widget->wires, i);
-		for(size_t p = 0; p < hda_get_item_fill(&wire->pixels); p++){
-			struct {size_t x, y;} pix;
-			hda_get(&wire->pixels, p, &pix);
-			if(wire->state){
+	hh_bitset_t* state = widget->history && widget->history->viewing ? &widget->history->view : &widget->state;
+	bool heatmap = false;
+	#ifdef BITWID_ACTIVITY
+	heatmap = widget->show_heatmap;
+	if(heatmap){
+		// Blue for quiet wires to red for the busiest one, on a log scale
+		fold_activity(widget);
+		uint64_t busiest = 1;
+		for(size_t i = 0; i < wires_count(&widget->wires); i++){
+			if(widget->activity[i] > busiest) busiest = widget->activity[i];
+		}
+		for(size_t i = 0; i < wires_count(&widget->wires); i++){
+			wire_t* wire = wires_ref(&widget->wires, i);
+			float heat = log1p((double)widget->activity[i]) / log1p((double)busiest);
+			Color color = {(unsigned char)(255 * heat), 32, (unsigned char)(255 * (1 - heat)), 255};
+			for(size_t p = 0; p < pixels_count(&wire->pixels); p++){
+				pixel_t pix = pixels_get(&wire->pixels, p);
+				DrawRectangle(pix.x*scale + x, pix.y*scale + y, scale, scale, color);
+			}
+		}
+	}
+	#endif
+	for(size_t i = 0; i < wires_count(&widget->wires) && !heatmap; i++){
+		wire_t* wire = wires_ref(&widget->wires, i);
+		for(size_t p = 0; p < pixels_count(&wire->pixels); p++){
+			pixel_t pix = pixels_get(&wire->pixels, p);
+			if(hbs_test(state, i)){
 				DrawRectangle(pix.x*scale + x, pix.y*scale + y, 
 									scale, scale, GetColor(wire->color));
 			}
@@ -514,9 +1549,8 @@ void bitwid_render_screen(bit_widget_t* widget, int x, int y, int scale){
 	}
 
 	// Draw Crossings
-	for(size_t i = 0; i < hda_get_item_fill(&widget->crossings); i++){
-		struct {size_t x, y;} pix;
-		hda_get(&widget->crossings, i, &pix);
+	for(size_t i = 0; i < pixels_count(&widget->crossings); i++){
+		pixel_t pix = pixels_get(&widget->crossings, i);
 		DrawRectangle(pix.x*scale + x, pix.y*scale + y, 
 							scale, scale, GetColor(WIRE_CROSSING));
 	}
@@ -524,30 +1558,44 @@ void bitwid_render_screen(bit_widget_t* widget, int x, int y, int scale){
 //-----------------------------------------------------------------------------
 void bitwid_simulate(bit_widget_t* widget, int steps){
 	for(int s = 0; s < steps; s++){
+		apply_stimulus(widget);
 		//Clear buffers
-		for(size_t i = 0; i < hda_get_item_fill(&widget->wires); i++){
-			wire_t* wire = hda_get_reference(&widget->wires, i);
-			if(!wire->touchable)
-				wire->state_buf = 0;
-		}
+		hbs_clear_all(&widget->drive);
 		// Evaluate Outputs of gates
-		for(size_t i = 0; i < hda_get_item_fill(&widget->gates); i++){
-			gate_t* gate = hda_get_reference(&widget->gates, i);
-			wire_t* wire_out = hda_get_reference(&widget->wires, gate->output_wire_id);
-			wire_t* wire_in = hda_get_reference(&widget->wires, gate->input_wire_id);
+		for(size_t i = 0; i < gates_count(&widget->gates); i++){
+			gate_t* gate = gates_ref(&widget->gates, i);
+			int input = hbs_test(&widget->state, gate->input_wire_id);
 			if(gate->type == NOT_GATE){
-				if(!wire_in->state) wire_out->state_buf = 1;
+				if(!input) hbs_set(&widget->drive, gate->output_wire_id);
 			}
 			else if(gate->type == DIODE){
-				if(wire_in->state) wire_out->state_buf = 1;
+				if(input) hbs_set(&widget->drive, gate->output_wire_id);
 			}
 		}
-		// Swap Buffers
-		for(size_t i = 0; i < hda_get_item_fill(&widget->wires); i++){
-			wire_t* wire = hda_get_reference(&widget->wires, i);
-			if(!wire->touchable)
-				wire->state = wire->state_buf;
+		// Swap Buffers, touchable wires keep their state
+		hbs_andnot(&widget->drive, &widget->drive, &widget->touchable);
+		hbs_and(&widget->state, &widget->state, &widget->touchable);
+		hbs_or(&widget->state, &widget->state, &widget->drive);
+		// Changes since the last step, including toggled inputs
+		hbs_xor(&widget->changed, &widget->last_state, &widget->state);
+		hbs_copy(&widget->last_state, &widget->state);
+		widget->tick++;
+		if(widget->recorder) recorder_append(widget->recorder, widget->tick, &widget->changed);
+		if(widget->history) history_append(widget);
+		if(probes_count(&widget->probes)) record_probes(widget);
+		#ifdef BITWID_ACTIVITY
+		count_activity(widget);
+		#endif
+		// Log watched pins that changed
+		for(size_t w = 0; w < pin_ids_count(&widget->watches); w++){
+			uint32_t pin = pin_ids_get(&widget->watches, w);
+			uint32_t wire_id = pins_ref(&widget->pins, pin)->wire_id;
+			if(hbs_test(&widget->changed, wire_id)){
+				watch_events_push(&widget->watch_log, 
+								  (watch_event_t){widget->tick, pin, hbs_test(&widget->state, wire_id)});
+			}
 		}
+		if(breakpoints_count(&widget->breakpoints) && check_breakpoints(widget)) break;
 	}
 }
 //-----------------------------------------------------------------------------
@@ -569,3 +1617,1724 @@ static void preprocess_image(bit_widget_t* widget){
 		}
 	}
 }
+//-----------------------------------------------------------------------------
+// Sets the inputs of every stimulus event due at the current tick
+static void apply_stimulus(bit_widget_t* widget){
+	size_t count = events_count(&widget->stimulus);
+	while(widget->stimulus_cursor < count){
+		stimulus_event_t* event = events_ref(&widget->stimulus, widget->stimulus_cursor);
+		if(event->tick > widget->tick) break;
+		hbs_assign(&widget->state, event->wire_id, event->value);
+		widget->stimulus_cursor++;
+	}
+}
+//-----------------------------------------------------------------------------
+static int compare_stimulus_events(const void* a, const void* b){
+	const stimulus_event_t* ea = a;
+	const stimulus_event_t* eb = b;
+	if(ea->tick != eb->tick) return ea->tick < eb->tick ? -1 : 1;
+	return ea->line < eb->line ? -1 : (ea->line > eb->line);
+}
+//-----------------------------------------------------------------------------
+// Wire id of a target written as "<x>,<y>", "#<wire_id>" or a pin name, -1 if none
+static size_t parse_wire_target(bit_widget_t* widget, const char* target){
+	if(is_pin_name(target)){
+		size_t pin = bitwid_find_pin(widget, target);
+		if(pin == (size_t)-1) return -1;
+		return pins_ref(&widget->pins, pin)->wire_id;
+	}
+	if(target[0] == '#'){
+		char* end;
+		unsigned long long wire_id = strtoull(target + 1, &end, 10);
+		if(*end != 0 || end == target + 1 || wire_id >= wires_count(&widget->wires)) return -1;
+		return wire_id;
+	}
+	unsigned long long x, y;
+	int length = 0;
+	if(sscanf(target, "%llu,%llu%n", &x, &y, &length) != 2 || target[length] != 0) return -1;
+	return get_wire_from_pixel(widget, x, y);
+}
+//-----------------------------------------------------------------------------
+// Loads input events, one per line as "<tick> <target> <0|1>". Lines
+// starting with '#' are comments. Events are resolved to wire ids and sorted
+// by tick here, so the simulation only compares the next tick per step.
+int bitwid_load_stimulus(bit_widget_t* widget, char* filename){
+	FILE* file = fopen(filename, "r");
+	if(!file){
+		printf("Error: Could not open stimulus file %s\n", filename);
+		return -1;
+	}
+	char line[256];
+	uint32_t line_number = 0;
+	while(fgets(line, sizeof(line), file)){
+		line_number++;
+		unsigned long long tick;
+		char target[128];
+		int value;
+		char* start = line + strspn(line, " \t");
+		if(*start == '#' || *start == '\n' || *start == '\r' || *start == 0) continue;
+		if(sscanf(start, "%llu %127s %d", &tick, target, &value) != 3 || (value != 0 && value != 1)){
+			printf("Error: %s:%u: expected <tick> <target> <0|1>\n", filename, line_number);
+			fclose(file);
+			return -1;
+		}
+		size_t wire_id = parse_wire_target(widget, target);
+		if(wire_id == (size_t)-1){
+			printf("Error: %s:%u: no wire at %s\n", filename, line_number, target);
+			fclose(file);
+			return -1;
+		}
+		if(!hbs_test(&widget->touchable, wire_id)){
+			printf("Warning: %s:%u: wire %zu is driven by a gate\n", filename, line_number, wire_id);
+		}
+		events_push(&widget->stimulus, (stimulus_event_t){tick, wire_id, line_number, value});
+	}
+	fclose(file);
+	qsort(hda_to_contiguous(&widget->stimulus), events_count(&widget->stimulus), 
+		  sizeof(stimulus_event_t), compare_stimulus_events);
+	// Skip events that are already in the past
+	widget->stimulus_cursor = 0;
+	while(widget->stimulus_cursor < events_count(&widget->stimulus) && 
+		  events_ref(&widget->stimulus, widget->stimulus_cursor)->tick < widget->tick){
+		widget->stimulus_cursor++;
+	}
+	printf("[BITWIDGETS] Loaded %zu stimulus events\n", events_count(&widget->stimulus));
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Pin names start with a letter or '_' and go on with letters, digits or '_'
+static bool is_pin_name(const char* name){
+	if(!(isalpha((unsigned char)name[0]) || name[0] == '_')) return false;
+	size_t length = strspn(name, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_");
+	return name[length] == 0 && length < BITWID_PIN_NAME;
+}
+//-----------------------------------------------------------------------------
+// Image path with its extension replaced by .pins, must be freed
+static char* get_pin_filename(const char* filename){
+	const char* dot = strrchr(filename, '.');
+	const char* slash = strrchr(filename, '/');
+	size_t length = (dot && (!slash || dot > slash)) ? (size_t)(dot - filename) : strlen(filename);
+	char* pin_filename = malloc(length + sizeof(".pins"));
+	memcpy(pin_filename, filename, length);
+	memcpy(pin_filename + length, ".pins", sizeof(".pins"));
+	return pin_filename;
+}
+//-----------------------------------------------------------------------------
+// Loads wire names, one per line as "<pin> <target>". Lines starting with
+// '#' are comments. Names are resolved to wire ids once here, a pin is an
+// input if no gate drives its wire. Replaces the pins loaded before.
+int bitwid_load_pins(bit_widget_t* widget, char* filename){
+	FILE* file = fopen(filename, "r");
+	if(!file){
+		printf("Error: Could not open pin file %s\n", filename);
+		return -1;
+	}
+	hda_clear(&widget->pins);
+	hda_clear(&widget->watches);
+	hda_clear(&widget->watch_log);
+	char line[256];
+	uint32_t line_number = 0;
+	while(fgets(line, sizeof(line), file)){
+		line_number++;
+		char name[128], target[128];
+		char* start = line + strspn(line, " \t");
+		if(*start == '#' || *start == '\n' || *start == '\r' || *start == 0) continue;
+		if(sscanf(start, "%127s %127s", name, target) != 2 || !is_pin_name(name) || is_pin_name(target)){
+			printf("Error: %s:%u: expected <pin> <x>,<y>|#<wire_id>\n", filename, line_number);
+			fclose(file);
+			return -1;
+		}
+		if(bitwid_find_pin(widget, name) != (size_t)-1){
+			printf("Error: %s:%u: pin %s is already defined\n", filename, line_number, name);
+			fclose(file);
+			return -1;
+		}
+		size_t wire_id = parse_wire_target(widget, target);
+		if(wire_id == (size_t)-1){
+			printf("Error: %s:%u: no wire at %s\n", filename, line_number, target);
+			fclose(file);
+			return -1;
+		}
+		pin_t pin = {.wire_id = wire_id, .input = hbs_test(&widget->touchable, wire_id)};
+		memcpy(pin.name, name, strlen(name) + 1);
+		pins_push(&widget->pins, pin);
+	}
+	fclose(file);
+	printf("[BITWIDGETS] Loaded %zu pins\n", pins_count(&widget->pins));
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Index of the pin with the name, -1 if none. Resolve pins once and use the
+// index with bitwid_get_pin and bitwid_set_pin afterwards.
+size_t bitwid_find_pin(bit_widget_t* widget, const char* name){
+	for(size_t i = 0; i < pins_count(&widget->pins); i++){
+		if(strcmp(pins_ref(&widget->pins, i)->name, name) == 0) return i;
+	}
+	return -1;
+}
+//-----------------------------------------------------------------------------
+// Log every change of the pin from the next step on
+void bitwid_watch_pin(bit_widget_t* widget, size_t pin){
+	uint32_t id = pin;
+	hda_append_no_dupe(&widget->watches, &id);
+}
+//-----------------------------------------------------------------------------
+// Starts every lane from the current state of the widget
+void lane_sim_init(lane_sim_t* sim, bit_widget_t* widget){
+	sim->widget = widget;
+	sim->wire_count = wires_count(&widget->wires);
+	size_t words = sim->wire_count ? sim->wire_count : 1;
+	sim->state = malloc(words * sizeof(uint64_t));
+	sim->drive = malloc(words * sizeof(uint64_t));
+	sim->hold = malloc(words * sizeof(uint64_t));
+	for(size_t i = 0; i < sim->wire_count; i++){
+		sim->hold[i] = -(uint64_t)hbs_test(&widget->touchable, i);
+	}
+	forces_init(&sim->forces);
+	lane_sim_reset(sim);
+}
+//-----------------------------------------------------------------------------
+void lane_sim_deinit(lane_sim_t* sim){
+	free(sim->state);
+	free(sim->drive);
+	free(sim->hold);
+	hda_deinit(&sim->forces);
+}
+//-----------------------------------------------------------------------------
+// Copies the widget state to every lane again and drops the forces
+void lane_sim_reset(lane_sim_t* sim){
+	for(size_t i = 0; i < sim->wire_count; i++){
+		sim->state[i] = -(uint64_t)hbs_test(&sim->widget->state, i);
+	}
+	sim->tick = sim->widget->tick;
+	sim->stimulus_cursor = sim->widget->stimulus_cursor;
+	hda_clear(&sim->forces);
+}
+//-----------------------------------------------------------------------------
+// Keeps the wire at value in one lane from now on, e.g. a stuck-at fault
+void lane_sim_force(lane_sim_t* sim, size_t wire_id, size_t lane, bool value){
+	forces_push(&sim->forces, (lane_force_t){wire_id, lane, value});
+	apply_lane_forces(sim);
+}
+//-----------------------------------------------------------------------------
+static void apply_lane_forces(lane_sim_t* sim){
+	for(size_t i = 0; i < forces_count(&sim->forces); i++){
+		lane_force_t* force = forces_ref(&sim->forces, i);
+		uint64_t mask = (uint64_t)1 << force->lane;
+		sim->state[force->wire_id] = (sim->state[force->wire_id] & ~mask) | (-(uint64_t)force->value & mask);
+	}
+}
+//-----------------------------------------------------------------------------
+// Same step as bitwid_simulate, on all lanes with one word operation
+void lane_sim_step(lane_sim_t* sim, uint64_t steps){
+	bit_widget_t* widget = sim->widget;
+	size_t gate_count = gates_count(&widget->gates);
+	size_t event_count = events_count(&widget->stimulus);
+	for(uint64_t s = 0; s < steps; s++){
+		// Stimulus drives every lane alike
+		while(sim->stimulus_cursor < event_count){
+			stimulus_event_t* event = events_ref(&widget->stimulus, sim->stimulus_cursor);
+			if(event->tick > sim->tick) break;
+			sim->state[event->wire_id] = -(uint64_t)event->value;
+			sim->stimulus_cursor++;
+		}
+		apply_lane_forces(sim);
+		memset(sim->drive, 0, sim->wire_count * sizeof(uint64_t));
+		for(size_t i = 0; i < gate_count; i++){
+			gate_t* gate = gates_ref(&widget->gates, i);
+			uint64_t input = sim->state[gate->input_wire_id];
+			sim->drive[gate->output_wire_id] |= gate->type == NOT_GATE ? ~input : input;
+		}
+		for(size_t i = 0; i < sim->wire_count; i++){
+			sim->state[i] = (sim->state[i] & sim->hold[i]) | (sim->drive[i] & ~sim->hold[i]);
+		}
+		apply_lane_forces(sim);
+		sim->tick++;
+	}
+}
+//-----------------------------------------------------------------------------
+// Wires compared by the fault simulation: the watched pins, or
+// every pin driven by a gate if nothing is watched
+static size_t get_observed_wires(bit_widget_t* widget, hh_darray_t* wire_ids){
+	for(size_t w = 0; w < pin_ids_count(&widget->watches); w++){
+		pin_ids_push(wire_ids, pins_ref(&widget->pins, pin_ids_get(&widget->watches, w))->wire_id);
+	}
+	if(pin_ids_count(wire_ids) == 0){
+		for(size_t p = 0; p < pins_count(&widget->pins); p++){
+			if(!pins_ref(&widget->pins, p)->input) pin_ids_push(wire_ids, pins_ref(&widget->pins, p)->wire_id);
+		}
+	}
+	return pin_ids_count(wire_ids);
+}
+//-----------------------------------------------------------------------------
+// Pin name of the wire if it has one, else its id and first pixel
+static void print_wire_name(bit_widget_t* widget, size_t wire_id){
+	for(size_t p = 0; p < pins_count(&widget->pins); p++){
+		if(pins_ref(&widget->pins, p)->wire_id == wire_id){
+			printf("%s", pins_ref(&widget->pins, p)->name);
+			return;
+		}
+	}
+	pixel_t seed = pixels_get(&wires_ref(&widget->wires, wire_id)->pixels, 0);
+	printf("#%zu(%zu,%zu)", wire_id, seed.x, seed.y);
+}
+//-----------------------------------------------------------------------------
+// Stuck-at-0 and stuck-at-1 on every wire. Lane 0 runs the fault free
+// circuit and each other lane one fault, so a pass covers BITWID_LANES-1
+// faults. A fault is detected once an observed wire differs from lane 0.
+static int run_fault_sim(bit_widget_t* widget, uint64_t ticks){
+	hh_darray_t observed; pin_ids_init(&observed);
+	if(get_observed_wires(widget, &observed) == 0){
+		printf("Error: Fault simulation needs output pins to observe, see --pins and --watch\n");
+		hda_deinit(&observed);
+		return -1;
+	}
+	hh_darray_t faults; faults_init(&faults);
+	for(size_t i = 0; i < wires_count(&widget->wires); i++){
+		faults_push(&faults, (fault_t){i, 0, UINT64_MAX});
+		faults_push(&faults, (fault_t){i, 1, UINT64_MAX});
+	}
+	lane_sim_t sim; lane_sim_init(&sim, widget);
+	size_t fault_count = faults_count(&faults);
+	size_t detected_count = 0;
+	double start_time = get_monotonic_time();
+	for(size_t first = 0; first < fault_count; first += BITWID_LANES - 1){
+		size_t lanes = fault_count - first < BITWID_LANES - 1 ? fault_count - first : BITWID_LANES - 1;
+		lane_sim_reset(&sim);
+		for(size_t l = 0; l < lanes; l++){
+			fault_t* fault = faults_ref(&faults, first + l);
+			lane_sim_force(&sim, fault->wire_id, l + 1, fault->value);
+		}
+		uint64_t pending = (lanes == 63 ? ~(uint64_t)0 : ((uint64_t)1 << (lanes + 1)) - 1) & ~(uint64_t)1;
+		for(uint64_t t = 0; t < ticks && pending; t++){
+			lane_sim_step(&sim, 1);
+			uint64_t differ = 0;
+			for(size_t o = 0; o < pin_ids_count(&observed); o++){
+				uint64_t word = sim.state[pin_ids_get(&observed, o)];
+				differ |= word ^ -(word & 1);
+			}
+			differ &= pending;
+			pending &= ~differ;
+			while(differ){
+				int lane = hh_bitset_word_ctz(differ);
+				faults_ref(&faults, first + lane - 1)->detected = sim.tick;
+				detected_count++;
+				differ &= differ - 1;
+			}
+		}
+	}
+	double elapsed = get_monotonic_time() - start_time;
+	for(size_t i = 0; i < fault_count; i++){
+		fault_t* fault = faults_ref(&faults, i);
+		printf("sa%d ", fault->value);
+		print_wire_name(widget, fault->wire_id);
+		if(fault->detected != UINT64_MAX) printf(" detected %llu\n", (unsigned long long)fault->detected);
+		else printf(" undetected\n");
+	}
+	printf("[BITWIDGETS] Fault coverage %zu/%zu (%.1f%%) in %.3f s | Observed wires: %zu\n", 
+		   detected_count, fault_count, fault_count ? 100.0 * detected_count / fault_count : 0.0, 
+		   elapsed, pin_ids_count(&observed));
+	lane_sim_deinit(&sim);
+	hda_deinit(&faults);
+	hda_deinit(&observed);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Lanes of one input when counting through input combinations, lane n of
+// batch b gets combination b*BITWID_LANES + n
+static uint64_t get_lane_pattern(uint64_t batch, size_t input){
+	static const uint64_t patterns[6] = {
+		0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL, 
+		0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+	};
+	if(input < 6) return patterns[input];
+	return -(uint64_t)((batch >> (input - 6)) & 1);
+}
+//-----------------------------------------------------------------------------
+// splitmix64
+static uint64_t next_random(uint64_t* seed){
+	uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+//-----------------------------------------------------------------------------
+// Drives both circuits with the same input vectors, one per lane, and
+// compares the observed pins every step. Every combination is tried when
+// there are at most BITWID_EXHAUSTIVE_INPUTS inputs, else random ones.
+// Inputs are the input pins of the widget, both are matched by pin name.
+// The other circuit gets the pins of pin_filename too if it is not 0, and
+// the stimulus of the widget on the pins of the same name.
+static int run_equivalence(bit_widget_t* widget, char* other_filename, char* pin_filename, uint64_t ticks){
+	bit_widget_t other; bitwid_init(&other, other_filename);
+	hh_darray_t observed; pin_ids_init(&observed);
+	hh_darray_t inputs; pin_ids_init(&inputs); // Pairs of wire ids, widget then other
+	hh_darray_t outputs; pin_ids_init(&outputs); // Same for the observed wires
+	hh_darray_t names; pin_ids_init(&names); // Pin of the widget for every pair
+	int result = 0;
+	if(pin_filename) result = bitwid_load_pins(&other, pin_filename);
+	// Names are unique, same count and every name found means the same set
+	if(result == 0 && pins_count(&other.pins) != pins_count(&widget->pins)){
+		printf("Error: %s has %zu pins, the circuit has %zu\n", other_filename, pins_count(&other.pins), pins_count(&widget->pins));
+		result = -1;
+	}
+	get_observed_wires(widget, &observed);
+	for(size_t p = 0; p < pins_count(&widget->pins) && result == 0; p++){
+		pin_t* pin = pins_ref(&widget->pins, p);
+		size_t other_pin = bitwid_find_pin(&other, pin->name);
+		if(other_pin == (size_t)-1 || pins_ref(&other.pins, other_pin)->input != pin->input){
+			printf("Error: %s has no %s pin named %s\n", other_filename, pin->input ? "input" : "output", pin->name);
+			result = -1;
+			break;
+		}
+		bool is_output = hda_is_inside(&observed, &pin->wire_id) != (size_t)-1;
+		if(!pin->input && !is_output) continue;
+		hh_darray_t* pairs = pin->input ? &inputs : &outputs;
+		pin_ids_push(pairs, pin->wire_id);
+		pin_ids_push(pairs, pins_ref(&other.pins, other_pin)->wire_id);
+		if(!pin->input) pin_ids_push(&names, p);
+	}
+	if(result == 0 && pin_ids_count(&outputs) == 0){
+		printf("Error: Equivalence check needs output pins to compare, see --pins and --watch\n");
+		result = -1;
+	}
+	if(result == 0) result = copy_stimulus_by_pin(widget, &other);
+	if(result != 0){
+		hda_deinit(&observed); hda_deinit(&inputs); hda_deinit(&outputs); hda_deinit(&names);
+		bitwid_deinit(&other);
+		return result;
+	}
+	size_t input_count = pin_ids_count(&inputs) / 2;
+	size_t output_count = pin_ids_count(&outputs) / 2;
+	bool exhaustive = input_count <= BITWID_EXHAUSTIVE_INPUTS;
+	uint64_t batches = exhaustive ? (((uint64_t)1 << input_count) + BITWID_LANES - 1) / BITWID_LANES : BITWID_RANDOM_BATCHES;
+	uint64_t seed = 0x5EED;
+	lane_sim_t sim_a; lane_sim_init(&sim_a, widget);
+	lane_sim_t sim_b; lane_sim_init(&sim_b, &other);
+	double start_time = get_monotonic_time();
+	for(uint64_t batch = 0; batch < batches && result == 0; batch++){
+		lane_sim_reset(&sim_a);
+		lane_sim_reset(&sim_b);
+		for(size_t i = 0; i < input_count; i++){
+			uint64_t lanes = exhaustive ? get_lane_pattern(batch, i) : next_random(&seed);
+			sim_a.state[pin_ids_get(&inputs, 2*i)] = lanes;
+			sim_b.state[pin_ids_get(&inputs, 2*i + 1)] = lanes;
+		}
+		for(uint64_t t = 1; t <= ticks && result == 0; t++){
+			lane_sim_step(&sim_a, 1);
+			lane_sim_step(&sim_b, 1);
+			uint64_t differ = 0;
+			for(size_t o = 0; o < output_count; o++){
+				differ |= sim_a.state[pin_ids_get(&outputs, 2*o)] ^ sim_b.state[pin_ids_get(&outputs, 2*o + 1)];
+			}
+			if(!differ) continue;
+			// Report the lowest diverging lane
+			int lane = hh_bitset_word_ctz(differ);
+			printf("[BITWIDGETS] Diverged %llu steps after applying vector %llu:", 
+				   (unsigned long long)t, (unsigned long long)(batch * BITWID_LANES + lane));
+			for(size_t p = 0; p < pins_count(&widget->pins); p++){
+				pin_t* pin = pins_ref(&widget->pins, p);
+				if(pin->input) printf(" %s=%d", pin->name, (int)((sim_a.state[pin->wire_id] >> lane) & 1));
+			}
+			printf("\n");
+			for(size_t o = 0; o < output_count; o++){
+				int a = (sim_a.state[pin_ids_get(&outputs, 2*o)] >> lane) & 1;
+				int b = (sim_b.state[pin_ids_get(&outputs, 2*o + 1)] >> lane) & 1;
+				printf("  %s: %d vs %d%s\n", pins_ref(&widget->pins, pin_ids_get(&names, o))->name, a, b, a != b ? " <" : "");
+			}
+			result = 1;
+		}
+	}
+	double elapsed = get_monotonic_time() - start_time;
+	if(result == 0){
+		printf("[BITWIDGETS] Equivalent on %llu %s vectors x %llu steps in %.3f s | Inputs: %zu | Outputs: %zu\n", 
+			   (unsigned long long)(exhaustive ? (uint64_t)1 << input_count : batches * BITWID_LANES), 
+			   exhaustive ? "exhaustive" : "random", (unsigned long long)ticks, elapsed, input_count, output_count);
+	}
+	lane_sim_deinit(&sim_a);
+	lane_sim_deinit(&sim_b);
+	hda_deinit(&observed); hda_deinit(&inputs); hda_deinit(&outputs); hda_deinit(&names);
+	bitwid_deinit(&other);
+	return result;
+}
+//-----------------------------------------------------------------------------
+// Gives other the pending stimulus of the widget, each event moved to the
+// wire of the pin with the same name and to the same step from now on
+static int copy_stimulus_by_pin(bit_widget_t* widget, bit_widget_t* other){
+	hda_clear(&other->stimulus);
+	other->stimulus_cursor = 0;
+	for(size_t e = widget->stimulus_cursor; e < events_count(&widget->stimulus); e++){
+		stimulus_event_t event = events_get(&widget->stimulus, e);
+		size_t p = 0;
+		while(p < pins_count(&widget->pins) && pins_ref(&widget->pins, p)->wire_id != event.wire_id) p++;
+		if(p == pins_count(&widget->pins)){
+			printf("Error: Stimulus line %u drives wire %u, which has no pin to find it by in both circuits\n", 
+				   event.line, event.wire_id);
+			return -1;
+		}
+		event.wire_id = pins_ref(&other->pins, bitwid_find_pin(other, pins_ref(&widget->pins, p)->name))->wire_id;
+		event.tick = event.tick - widget->tick + other->tick;
+		events_push(&other->stimulus, event);
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Settles every input combination for ticks steps, 64 combinations per lane
+// simulator pass. Small tables are printed row by row, every table is
+// summarized per output as a hex lookup table, bit n for combination n where
+// input i is bit i of n. Outputs still changing at the last step are unstable.
+static int run_truth_table(bit_widget_t* widget, uint64_t ticks){
+	hh_darray_t inputs; pin_ids_init(&inputs); // Pin indices
+	hh_darray_t outputs; pin_ids_init(&outputs); // Observed wire ids
+	for(size_t p = 0; p < pins_count(&widget->pins); p++){
+		if(pins_ref(&widget->pins, p)->input) pin_ids_push(&inputs, p);
+	}
+	size_t input_count = pin_ids_count(&inputs);
+	size_t output_count = get_observed_wires(widget, &outputs);
+	if(input_count > BITWID_TRUTH_INPUTS || output_count == 0){
+		if(output_count == 0) printf("Error: Truth table needs output pins, see --pins and --watch\n");
+		else printf("Error: Truth table of %zu inputs, at most %d are supported\n", input_count, BITWID_TRUTH_INPUTS);
+		hda_deinit(&inputs);
+		hda_deinit(&outputs);
+		return -1;
+	}
+	size_t rows = (size_t)1 << input_count;
+	uint64_t valid = rows < BITWID_LANES ? ((uint64_t)1 << rows) - 1 : ~(uint64_t)0;
+	hh_bitset_t* tables = malloc(output_count * sizeof(hh_bitset_t));
+	for(size_t o = 0; o < output_count; o++) hbs_init(&tables[o], rows);
+	hh_bitset_t unstable; hbs_init(&unstable, rows);
+	lane_sim_t sim; lane_sim_init(&sim, widget);
+	uint64_t* last = malloc(output_count * sizeof(uint64_t));
+	double start_time = get_monotonic_time();
+	for(uint64_t batch = 0; batch * BITWID_LANES < rows; batch++){
+		lane_sim_reset(&sim);
+		for(size_t i = 0; i < input_count; i++){
+			sim.state[pins_ref(&widget->pins, pin_ids_get(&inputs, i))->wire_id] = get_lane_pattern(batch, i);
+		}
+		if(ticks > 1) lane_sim_step(&sim, ticks - 1);
+		for(size_t o = 0; o < output_count; o++) last[o] = sim.state[pin_ids_get(&outputs, o)];
+		lane_sim_step(&sim, 1);
+		// Batches are word aligned in the tables, rows below 64 fit in one word
+		uint64_t changing = 0;
+		for(size_t o = 0; o < output_count; o++){
+			uint64_t word = sim.state[pin_ids_get(&outputs, o)];
+			changing |= word ^ last[o];
+			tables[o].data[batch] = word & valid;
+		}
+		unstable.data[batch] = changing & valid;
+	}
+	double elapsed = get_monotonic_time() - start_time;
+	if(input_count <= BITWID_TRUTH_ROW_INPUTS){
+		for(size_t i = 0; i < input_count; i++) printf("%s ", pins_ref(&widget->pins, pin_ids_get(&inputs, i))->name);
+		printf("|");
+		for(size_t o = 0; o < output_count; o++){
+			printf(" ");
+			print_wire_name(widget, pin_ids_get(&outputs, o));
+		}
+		printf("\n");
+		for(size_t row = 0; row < rows; row++){
+			for(size_t i = 0; i < input_count; i++) printf("%d ", (int)((row >> i) & 1));
+			printf("|");
+			for(size_t o = 0; o < output_count; o++){
+				printf(" %c", hbs_test(&unstable, row) ? '?' : '0' + hbs_test(&tables[o], row));
+			}
+			printf("\n");
+		}
+	}
+	for(size_t o = 0; o < output_count; o++){
+		print_wire_name(widget, pin_ids_get(&outputs, o));
+		size_t ones = hbs_popcount(&tables[o]);
+		printf(" = 0x");
+		// Most significant combination first, at least one digit
+		size_t digits = rows < 4 ? 1 : rows / 4;
+		for(size_t d = digits; d-- > 0;){
+			printf("%x", (unsigned)((tables[o].data[d / 16] >> ((d % 16) * 4)) & 0xF));
+		}
+		if(ones == 0 || ones == rows) printf(" (constant %d)", ones != 0);
+		printf("\n");
+	}
+	size_t unstable_count = hbs_popcount(&unstable);
+	printf("[BITWIDGETS] Truth table of %zu inputs x %zu outputs in %.3f s", input_count, output_count, elapsed);
+	if(unstable_count) printf(" | %zu combinations still changing after %llu steps", unstable_count, (unsigned long long)ticks);
+	printf("\n");
+	free(last);
+	lane_sim_deinit(&sim);
+	hbs_deinit(&unstable);
+	for(size_t o = 0; o < output_count; o++) hbs_deinit(&tables[o]);
+	free(tables);
+	hda_deinit(&inputs);
+	hda_deinit(&outputs);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// LEB128, 7 bits per byte with the high bit set on all but the last one
+static void put_varint(hh_darray_t* bytes, uint64_t value){
+	uint8_t buffer[10];
+	size_t length = 0;
+	while(value >= 0x80){
+		buffer[length++] = (uint8_t)value | 0x80;
+		value >>= 7;
+	}
+	buffer[length++] = (uint8_t)value;
+	hda_append_n(bytes, buffer, length);
+}
+//-----------------------------------------------------------------------------
+static uint64_t get_varint(uint8_t** cursor){
+	uint64_t value = 0;
+	int shift = 0;
+	while(**cursor & 0x80){
+		value |= (uint64_t)(*(*cursor)++ & 0x7F) << shift;
+		shift += 7;
+	}
+	value |= (uint64_t)(*(*cursor)++) << shift;
+	return value;
+}
+//-----------------------------------------------------------------------------
+// Starts recording from the current state of the widget. Changes are written
+// by a background thread, or only kept for the last ring_ticks ticks and
+// written when the recording stops.
+int recorder_start(bit_widget_t* widget, char* filename, uint64_t ring_ticks){
+	FILE* file = fopen(filename, "wb");
+	if(!file){
+		printf("Error: Could not open record file %s\n", filename);
+		return -1;
+	}
+	recorder_t* recorder = calloc(1, sizeof(recorder_t));
+	recorder->widget = widget;
+	recorder->wire_count = widget->state.bits;
+	recorder->words = widget->state.words;
+	pins_init(&recorder->pins);
+	for(size_t p = 0; p < pins_count(&widget->pins); p++) pins_push(&recorder->pins, pins_get(&widget->pins, p));
+	hda_init(&recorder->ids, sizeof(uint8_t));
+	recorder->file = file;
+	size_t length = strlen(filename);
+	recorder->vcd = length >= 4 && strcmp(filename + length - 4, ".vcd") == 0;
+	recorder->ring_ticks = ring_ticks;
+	recorder->vcd_state = calloc(widget->state.words ? widget->state.words : 1, sizeof(uint64_t));
+	hdq_init(&recorder->ring, sizeof(record_chunk_t*));
+	hdq_init(&recorder->queue, sizeof(record_chunk_t*));
+	pthread_mutex_init(&recorder->lock, 0);
+	pthread_cond_init(&recorder->wake, 0);
+	recorder->chunk = new_record_chunk(&widget->state, widget->tick);
+	if(pthread_create(&recorder->thread, 0, recorder_worker, recorder) != 0){
+		printf("Error: Could not start the writer of %s\n", filename);
+		free_record_chunk(recorder->chunk);
+		hdq_deinit(&recorder->ring);
+		hdq_deinit(&recorder->queue);
+		pthread_mutex_destroy(&recorder->lock);
+		pthread_cond_destroy(&recorder->wake);
+		free(recorder->vcd_state);
+		hda_deinit(&recorder->pins);
+		hda_deinit(&recorder->ids);
+		free(recorder);
+		fclose(file);
+		return -1;
+	}
+	widget->recorder = recorder;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Hands the rest to the writer, waits for it and closes the file
+void recorder_stop(bit_widget_t* widget){
+	recorder_t* recorder = widget->recorder;
+	seal_record_chunk(recorder, widget->tick);
+	if(hdq_get_item_fill(&recorder->ring)){
+		// Chunks are dropped whole while recording, cut the oldest one to the
+		// exact start of the last ring_ticks ticks
+		uint64_t from = widget->tick > recorder->ring_ticks ? widget->tick - recorder->ring_ticks : 0;
+		while(hdq_get_item_fill(&recorder->ring) > 1){
+			record_chunk_t* second = *(record_chunk_t**)hdq_get_reference(&recorder->ring, 1);
+			if(second->start_tick > from) break;
+			record_chunk_t* oldest;
+			hdq_pop_front(&recorder->ring, &oldest);
+			free_record_chunk(oldest);
+		}
+		trim_record_chunk(*(record_chunk_t**)hdq_get_reference(&recorder->ring, 0), from);
+	}
+	pthread_mutex_lock(&recorder->lock);
+	while(hdq_get_item_fill(&recorder->ring)){
+		record_chunk_t* chunk;
+		hdq_pop_front(&recorder->ring, &chunk);
+		hdq_push_back(&recorder->queue, &chunk);
+	}
+	recorder->stop = 1;
+	pthread_cond_signal(&recorder->wake);
+	pthread_mutex_unlock(&recorder->lock);
+	pthread_join(recorder->thread, 0);
+	free_record_chunk(recorder->chunk);
+	fclose(recorder->file);
+	hdq_deinit(&recorder->ring);
+	hdq_deinit(&recorder->queue);
+	pthread_mutex_destroy(&recorder->lock);
+	pthread_cond_destroy(&recorder->wake);
+	free(recorder->vcd_state);
+	hda_deinit(&recorder->pins);
+	hda_deinit(&recorder->ids);
+	free(recorder);
+	widget->recorder = 0;
+}
+//-----------------------------------------------------------------------------
+// Called by bitwid_simulate after every step, cost grows with the changes
+static void recorder_append(recorder_t* recorder, uint64_t tick, hh_bitset_t* changed){
+	append_record_changes(recorder->chunk, tick, changed, &recorder->ids);
+	if(hda_get_item_fill(&recorder->chunk->bytes) >= BITWID_RECORD_CHUNK) seal_record_chunk(recorder, tick);
+}
+//-----------------------------------------------------------------------------
+// Stores the changes of a tick, ticks without changes take no space. The
+// changed words are walked once, their ids go to ids until the count is known.
+static void append_record_changes(record_chunk_t* chunk, uint64_t tick, hh_bitset_t* changed, hh_darray_t* ids){
+	size_t count = 0;
+	size_t last_id = 0;
+	hda_clear(ids);
+	for(size_t w = 0; w < changed->words; w++){
+		uint64_t word = changed->data[w];
+		if(!word) continue;
+		count += hh_bitset_word_popcount(word);
+		while(word){
+			size_t id = (w << 6) + hh_bitset_word_ctz(word);
+			put_varint(ids, id - last_id);
+			last_id = id;
+			word &= word - 1;
+		}
+	}
+	if(!count) return;
+	put_varint(&chunk->bytes, tick - chunk->last_tick);
+	put_varint(&chunk->bytes, count);
+	hda_append_n(&chunk->bytes, hda_to_contiguous(ids), hda_get_item_fill(ids));
+	chunk->last_tick = tick;
+}
+//-----------------------------------------------------------------------------
+// Wire states at tick until, which must not be before the chunk start
+static void replay_record_chunk(record_chunk_t* chunk, uint64_t until, uint64_t* state){
+	size_t byte_count = hda_get_item_fill(&chunk->bytes);
+	memcpy(state, chunk->snapshot, HH_BITSET_WORDS(chunk->wire_count) * sizeof(uint64_t));
+	if(!byte_count) return;
+	uint8_t* cursor = hda_to_contiguous(&chunk->bytes);
+	uint8_t* end = cursor + byte_count;
+	uint64_t tick = chunk->start_tick;
+	while(cursor < end){
+		tick += get_varint(&cursor);
+		if(tick > until) return;
+		size_t count = get_varint(&cursor);
+		size_t id = 0;
+		for(size_t c = 0; c < count; c++){
+			id += get_varint(&cursor);
+			state[id >> 6] ^= (uint64_t)1 << (id & 63);
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+static record_chunk_t* new_record_chunk(hh_bitset_t* state, uint64_t tick){
+	record_chunk_t* chunk = malloc(sizeof(record_chunk_t));
+	chunk->wire_count = state->bits;
+	chunk->start_tick = tick;
+	chunk->last_tick = tick;
+	chunk->snapshot = malloc((state->words ? state->words : 1) * sizeof(uint64_t));
+	memcpy(chunk->snapshot, state->data, state->words * sizeof(uint64_t));
+	hda_init(&chunk->bytes, sizeof(uint8_t));
+	return chunk;
+}
+//-----------------------------------------------------------------------------
+static void free_record_chunk(record_chunk_t* chunk){
+	free(chunk->snapshot);
+	hda_deinit(&chunk->bytes);
+	free(chunk);
+}
+//-----------------------------------------------------------------------------
+// Moves the start of the chunk to tick from, its snapshot takes the changes
+// up to there and only the later ones are kept
+static void trim_record_chunk(record_chunk_t* chunk, uint64_t from){
+	if(from <= chunk->start_tick) return;
+	size_t words = HH_BITSET_WORDS(chunk->wire_count);
+	uint64_t* snapshot = malloc((words ? words : 1) * sizeof(uint64_t));
+	replay_record_chunk(chunk, from, snapshot);
+	free(chunk->snapshot);
+	chunk->snapshot = snapshot;
+	hh_darray_t bytes; hda_init(&bytes, sizeof(uint8_t));
+	size_t byte_count = hda_get_item_fill(&chunk->bytes);
+	uint8_t* cursor = byte_count ? hda_to_contiguous(&chunk->bytes) : 0;
+	uint8_t* end = cursor + byte_count;
+	uint64_t tick = chunk->start_tick;
+	uint64_t last_tick = from;
+	while(cursor < end){
+		tick += get_varint(&cursor);
+		size_t count = get_varint(&cursor);
+		bool kept = tick > from;
+		if(kept){
+			put_varint(&bytes, tick - last_tick);
+			put_varint(&bytes, count);
+			last_tick = tick;
+		}
+		for(size_t c = 0; c < count; c++){
+			uint64_t delta = get_varint(&cursor);
+			if(kept) put_varint(&bytes, delta);
+		}
+	}
+	hda_deinit(&chunk->bytes);
+	chunk->bytes = bytes;
+	chunk->start_tick = from;
+	chunk->last_tick = last_tick;
+}
+//-----------------------------------------------------------------------------
+// Moves the filled chunk to the writer, or to the ring dropping the chunks
+// that are no longer needed to cover the last ring_ticks ticks
+static void seal_record_chunk(recorder_t* recorder, uint64_t tick){
+	record_chunk_t* chunk = recorder->chunk;
+	recorder->chunk = new_record_chunk(&recorder->widget->state, tick);
+	if(recorder->ring_ticks){
+		hdq_push_back(&recorder->ring, &chunk);
+		while(hdq_get_item_fill(&recorder->ring) > 1){
+			record_chunk_t* second = *(record_chunk_t**)hdq_get_reference(&recorder->ring, 1);
+			if(second->start_tick + recorder->ring_ticks > tick) break;
+			record_chunk_t* oldest;
+			hdq_pop_front(&recorder->ring, &oldest);
+			free_record_chunk(oldest);
+		}
+		return;
+	}
+	pthread_mutex_lock(&recorder->lock);
+	hdq_push_back(&recorder->queue, &chunk);
+	pthread_cond_signal(&recorder->wake);
+	pthread_mutex_unlock(&recorder->lock);
+}
+//-----------------------------------------------------------------------------
+static void* recorder_worker(void* arg){
+	recorder_t* recorder = arg;
+	pthread_mutex_lock(&recorder->lock);
+	while(1){
+		while(!hdq_get_item_fill(&recorder->queue) && !recorder->stop){
+			pthread_cond_wait(&recorder->wake, &recorder->lock);
+		}
+		if(!hdq_get_item_fill(&recorder->queue)) break;
+		record_chunk_t* chunk;
+		hdq_pop_front(&recorder->queue, &chunk);
+		pthread_mutex_unlock(&recorder->lock);
+		write_record_chunk(recorder, chunk);
+		free_record_chunk(chunk);
+		pthread_mutex_lock(&recorder->lock);
+	}
+	pthread_mutex_unlock(&recorder->lock);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// VCD identifier of a wire, base 94 over the printable characters
+static void write_vcd_id(FILE* file, size_t wire_id){
+	do{
+		fputc('!' + (int)(wire_id % 94), file);
+		wire_id /= 94;
+	}while(wire_id);
+}
+//-----------------------------------------------------------------------------
+// Binary format: "BWREC1\n", varint wire count, then every chunk as varint
+// start tick, snapshot words, varint byte count and the change bytes.
+// VCD: every wire is a 1 bit var named after its pin or "w<id>".
+static void write_record_chunk(recorder_t* recorder, record_chunk_t* chunk){
+	FILE* file = recorder->file;
+	size_t wire_count = recorder->wire_count;
+	size_t words = recorder->words;
+	size_t byte_count = hda_get_item_fill(&chunk->bytes);
+	if(!recorder->vcd){
+		hh_darray_t head; hda_init(&head, sizeof(uint8_t));
+		if(!recorder->header_written){
+			hda_append_n(&head, "BWREC1\n", 7);
+			put_varint(&head, wire_count);
+		}
+		put_varint(&head, chunk->start_tick);
+		fwrite(hda_to_contiguous(&head), 1, hda_get_item_fill(&head), file);
+		hda_clear(&head);
+		fwrite(chunk->snapshot, sizeof(uint64_t), words, file);
+		put_varint(&head, byte_count);
+		fwrite(hda_to_contiguous(&head), 1, hda_get_item_fill(&head), file);
+		if(byte_count) fwrite(hda_to_contiguous(&chunk->bytes), 1, byte_count, file);
+		hda_deinit(&head);
+		recorder->header_written = 1;
+		return;
+	}
+	if(!recorder->header_written){
+		fprintf(file, "$timescale 1 ns $end\n$scope module bitwidgets $end\n");
+		for(size_t i = 0; i < wire_count; i++){
+			fprintf(file, "$var wire 1 ");
+			write_vcd_id(file, i);
+			size_t p = 0;
+			while(p < pins_count(&recorder->pins) && pins_ref(&recorder->pins, p)->wire_id != i) p++;
+			if(p < pins_count(&recorder->pins)) fprintf(file, " %s $end\n", pins_ref(&recorder->pins, p)->name);
+			else fprintf(file, " w%zu $end\n", i);
+		}
+		fprintf(file, "$upscope $end\n$enddefinitions $end\n#%llu\n$dumpvars\n", (unsigned long long)chunk->start_tick);
+		for(size_t i = 0; i < wire_count; i++){
+			fputc('0' + (int)((chunk->snapshot[i >> 6] >> (i & 63)) & 1), file);
+			write_vcd_id(file, i);
+			fputc('\n', file);
+		}
+		fprintf(file, "$end\n");
+		memcpy(recorder->vcd_state, chunk->snapshot, words * sizeof(uint64_t));
+		recorder->header_written = 1;
+	}
+	else if(memcmp(recorder->vcd_state, chunk->snapshot, words * sizeof(uint64_t)) != 0){
+		// Ring mode dropped ticks in between, write the wires that differ
+		fprintf(file, "#%llu\n", (unsigned long long)chunk->start_tick);
+		for(size_t i = 0; i < wire_count; i++){
+			uint64_t bit = (chunk->snapshot[i >> 6] >> (i & 63)) & 1;
+			if(bit == ((recorder->vcd_state[i >> 6] >> (i & 63)) & 1)) continue;
+			fputc('0' + (int)bit, file);
+			write_vcd_id(file, i);
+			fputc('\n', file);
+		}
+		memcpy(recorder->vcd_state, chunk->snapshot, words * sizeof(uint64_t));
+	}
+	if(!byte_count) return;
+	uint8_t* cursor = hda_to_contiguous(&chunk->bytes);
+	uint8_t* end = cursor + byte_count;
+	uint64_t tick = chunk->start_tick;
+	while(cursor < end){
+		tick += get_varint(&cursor);
+		size_t count = get_varint(&cursor);
+		fprintf(file, "#%llu\n", (unsigned long long)tick);
+		size_t id = 0;
+		for(size_t c = 0; c < count; c++){
+			id += get_varint(&cursor);
+			recorder->vcd_state[id >> 6] ^= (uint64_t)1 << (id & 63);
+			fputc('0' + (int)((recorder->vcd_state[id >> 6] >> (id & 63)) & 1), file);
+			write_vcd_id(file, id);
+			fputc('\n', file);
+		}
+	}
+}
+#ifdef BITWID_ACTIVITY
+//-----------------------------------------------------------------------------
+// Adds the changed bits of the step to the bit sliced counters, 64 wires per
+// word operation. Carries stop at the first plane they don't overflow.
+static void count_activity(bit_widget_t* widget){
+	uint64_t* planes = widget->activity_planes;
+	for(size_t w = 0; w < widget->changed.words; w++){
+		uint64_t carry = widget->changed.data[w];
+		uint64_t* plane = planes + w * BITWID_ACTIVITY_PLANES;
+		for(int p = 0; carry && p < BITWID_ACTIVITY_PLANES; p++){
+			uint64_t old = plane[p];
+			plane[p] = old ^ carry;
+			carry &= old;
+		}
+	}
+	// Fold before the counters can overflow
+	if(++widget->activity_pending == (1u << BITWID_ACTIVITY_PLANES) - 1) fold_activity(widget);
+}
+//-----------------------------------------------------------------------------
+// Moves the bit sliced counts into the per wire totals
+static void fold_activity(bit_widget_t* widget){
+	uint64_t* planes = widget->activity_planes;
+	for(size_t w = 0; w < widget->changed.words; w++){
+		uint64_t* plane = planes + w * BITWID_ACTIVITY_PLANES;
+		uint64_t any = 0;
+		for(int p = 0; p < BITWID_ACTIVITY_PLANES; p++) any |= plane[p];
+		while(any){
+			int bit = hh_bitset_word_ctz(any);
+			uint64_t count = 0;
+			for(int p = 0; p < BITWID_ACTIVITY_PLANES; p++) count |= ((plane[p] >> bit) & 1) << p;
+			widget->activity[(w << 6) + bit] += count;
+			any &= any - 1;
+		}
+		memset(plane, 0, BITWID_ACTIVITY_PLANES * sizeof(uint64_t));
+	}
+	widget->activity_pending = 0;
+}
+//-----------------------------------------------------------------------------
+static int compare_activity(const void* a, const void* b){
+	const uint64_t* ea = a;
+	const uint64_t* eb = b;
+	if(ea[0] != eb[0]) return ea[0] > eb[0] ? -1 : 1;
+	return ea[1] < eb[1] ? -1 : (ea[1] > eb[1]);
+}
+//-----------------------------------------------------------------------------
+// Prints the busiest wires as: <toggles> <pin or wire>
+void bitwid_dump_activity(bit_widget_t* widget, size_t top){
+	fold_activity(widget);
+	size_t wire_count = wires_count(&widget->wires);
+	uint64_t* ranks = malloc((wire_count ? wire_count : 1) * 2 * sizeof(uint64_t)); // Toggles and wire id pairs
+	for(size_t i = 0; i < wire_count; i++){
+		ranks[2*i] = widget->activity[i];
+		ranks[2*i + 1] = i;
+	}
+	qsort(ranks, wire_count, 2 * sizeof(uint64_t), compare_activity);
+	printf("[BITWIDGETS] Busiest wires over %llu ticks:\n", (unsigned long long)widget->tick);
+	for(size_t i = 0; i < top && i < wire_count; i++){
+		printf("%llu ", (unsigned long long)ranks[2*i]);
+		print_wire_name(widget, ranks[2*i + 1]);
+		printf("\n");
+	}
+	free(ranks);
+}
+#endif
+//-----------------------------------------------------------------------------
+// Adds a probe to the wire or removes the one it has, returns if it was added
+bool bitwid_toggle_probe(bit_widget_t* widget, size_t wire_id){
+	for(size_t i = 0; i < probes_count(&widget->probes); i++){
+		probe_t* probe = probes_ref(&widget->probes, i);
+		if(probe->wire_id != wire_id) continue;
+		free(probe->history);
+		for(int l = 0; l < BITWID_PROBE_LEVELS; l++){
+			hbs_deinit(&probe->any[l]);
+			hbs_deinit(&probe->all[l]);
+		}
+		hda_pop(&widget->probes, i, 0);
+		return false;
+	}
+	probe_t probe = {.wire_id = wire_id, .start_tick = widget->tick};
+	probe.history = calloc(BITWID_PROBE_TICKS / 64, sizeof(uint64_t));
+	for(int l = 0; l < BITWID_PROBE_LEVELS; l++){
+		hbs_init(&probe.any[l], BITWID_PROBE_TICKS >> (6*(l+1)));
+		hbs_init(&probe.all[l], BITWID_PROBE_TICKS >> (6*(l+1)));
+	}
+	probes_push(&widget->probes, probe);
+	return true;
+}
+//-----------------------------------------------------------------------------
+// Stores the states of the probed wires for the tick just simulated. Every
+// completed block of 64 ticks, or of 64 blocks of a level, is summarized in
+// the level above, so a long span is read from a handful of summary bits.
+static void record_probes(bit_widget_t* widget){
+	uint64_t slot = widget->tick % BITWID_PROBE_TICKS;
+	uint64_t mask = (uint64_t)1 << (slot & 63);
+	for(size_t i = 0; i < probes_count(&widget->probes); i++){
+		probe_t* probe = probes_ref(&widget->probes, i);
+		if(hbs_test(&widget->state, probe->wire_id)) probe->history[slot >> 6] |= mask;
+		else probe->history[slot >> 6] &= ~mask;
+		for(int l = 0; l < BITWID_PROBE_LEVELS; l++){
+			if(((slot + 1) & ((1ull << (6*(l+1))) - 1)) != 0) break;
+			size_t block = slot >> (6*(l+1));
+			uint64_t any = l ? probe->any[l-1].data[block] : probe->history[block];
+			uint64_t all = l ? probe->all[l-1].data[block] : probe->history[block];
+			hbs_assign(&probe->any[l], block, any != 0);
+			hbs_assign(&probe->all[l], block, all == ~(uint64_t)0);
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+// What the probe saw in ticks [from, to): bit 0 set for a high tick, bit 1
+// for a low one. Uses the largest summary blocks that fit in the range.
+static int get_probe_range(probe_t* probe, uint64_t from, uint64_t to){
+	int seen = 0;
+	while(from < to && seen != 3){
+		int level = BITWID_PROBE_LEVELS;
+		while(level > 0){
+			uint64_t size = 1ull << (6*level);
+			if(from % size == 0 && from + size <= to) break;
+			level--;
+		}
+		uint64_t slot = from % BITWID_PROBE_TICKS;
+		if(level == 0){
+			seen |= (probe->history[slot >> 6] >> (slot & 63)) & 1 ? 1 : 2;
+			from++;
+			continue;
+		}
+		size_t block = slot >> (6*level);
+		if(hbs_test(&probe->any[level-1], block)) seen |= 1;
+		if(!hbs_test(&probe->all[level-1], block)) seen |= 2;
+		from += 1ull << (6*level);
+	}
+	return seen;
+}
+//-----------------------------------------------------------------------------
+// Draws a strip per probe with the last probe_span ticks, newest on the
+// right. Pixel columns that look the same are merged into one rectangle.
+void bitwid_render_probes(bit_widget_t* widget, int x, int y, int width){
+	if(width <= 0) return;
+	uint64_t end = widget->tick + 1; // Ticks before end are recorded
+	uint64_t span = widget->probe_span;
+	for(size_t i = 0; i < probes_count(&widget->probes); i++){
+		probe_t* probe = probes_ref(&widget->probes, i);
+		int top = y + i * BITWID_PROBE_HEIGHT;
+		Color color = GetColor(wires_ref(&widget->wires, probe->wire_id)->color);
+		DrawRectangle(x, top, width, BITWID_PROBE_HEIGHT, (Color){0, 0, 0, 192});
+		uint64_t oldest = probe->start_tick + 1;
+		if(end > BITWID_PROBE_TICKS && end - BITWID_PROBE_TICKS > oldest) oldest = end - BITWID_PROBE_TICKS;
+		int run_start = 0, run_seen = 0;
+		for(int column = 0; column <= width; column++){
+			int seen = 0;
+			if(column < width){
+				// Ticks of the column, clipped to the recorded ones
+				uint64_t back_from = span - span * column / width;
+				uint64_t back_to = span - span * (column + 1) / width;
+				uint64_t from = end > back_from ? end - back_from : 0;
+				uint64_t to = end > back_to ? end - back_to : 0;
+				if(from < oldest) from = oldest;
+				if(from < to) seen = get_probe_range(probe, from, to);
+				if(seen == run_seen) continue;
+			}
+			int run_width = column - run_start;
+			if(run_seen == 1) DrawRectangle(x + run_start, top + 2, run_width, 2, color);
+			else if(run_seen == 2) DrawRectangle(x + run_start, top + BITWID_PROBE_HEIGHT - 4, run_width, 2, lower_color(color));
+			else if(run_seen == 3) DrawRectangle(x + run_start, top + 2, run_width, BITWID_PROBE_HEIGHT - 4, lower_color(color));
+			// Edge between a high and a low run
+			if((run_seen | seen) == 3 && run_seen != 3 && seen != 3 && column < width){
+				DrawRectangle(x + column, top + 2, 1, BITWID_PROBE_HEIGHT - 4, color);
+			}
+			run_start = column;
+			run_seen = seen;
+		}
+		size_t p = 0;
+		while(p < pins_count(&widget->pins) && pins_ref(&widget->pins, p)->wire_id != probe->wire_id) p++;
+		if(p < pins_count(&widget->pins)) DrawText(pins_ref(&widget->pins, p)->name, x + 2, top + 7, 10, WHITE);
+		else DrawText(TextFormat("#%u", probe->wire_id), x + 2, top + 7, 10, WHITE);
+	}
+}
+//-----------------------------------------------------------------------------
+// Compiles terms joined by '&' and '|', '&' binding tighter. A term is a wire
+// target as in the stimulus file, '!' in front of it asks for it to be low.
+int bitwid_add_breakpoint(bit_widget_t* widget, const char* expression){
+	breakpoint_t breakpoint = {0};
+	if(strlen(expression) >= BITWID_BREAK_EXPRESSION){
+		printf("Error: Breakpoint expression is too long: %s\n", expression);
+		return -1;
+	}
+	memcpy(breakpoint.expression, expression, strlen(expression) + 1);
+	break_terms_init(&breakpoint.terms);
+	word_masks_init(&breakpoint.triggers);
+	uint32_t clause = 0;
+	const char* cursor = expression;
+	bool expect_term = true;
+	while(1){
+		cursor += strspn(cursor, " \t");
+		if(!expect_term){
+			if(*cursor == 0) break;
+			if(*cursor == '|') clause++;
+			else if(*cursor != '&') break;
+			cursor++;
+			expect_term = true;
+			continue;
+		}
+		bool negate = *cursor == '!';
+		if(negate) cursor += 1 + strspn(cursor + 1, " \t");
+		char target[BITWID_BREAK_EXPRESSION];
+		size_t length = strcspn(cursor, " \t&|");
+		memcpy(target, cursor, length);
+		target[length] = 0;
+		size_t wire_id = length ? parse_wire_target(widget, target) : (size_t)-1;
+		if(wire_id == (size_t)-1){
+			printf("Error: Breakpoint %s: no wire at \"%s\"\n", expression, target);
+			hda_deinit(&breakpoint.terms);
+			hda_deinit(&breakpoint.triggers);
+			return -1;
+		}
+		cursor += length;
+		expect_term = false;
+		// Wires of the same word in a clause share one test
+		uint32_t word = wire_id >> 6;
+		uint64_t bit = (uint64_t)1 << (wire_id & 63);
+		size_t t = 0;
+		while(t < break_terms_count(&breakpoint.terms) && 
+			  (break_terms_ref(&breakpoint.terms, t)->clause != clause || break_terms_ref(&breakpoint.terms, t)->word != word)) t++;
+		if(t == break_terms_count(&breakpoint.terms)) break_terms_push(&breakpoint.terms, (break_term_t){clause, word, 0, 0});
+		if(negate) break_terms_ref(&breakpoint.terms, t)->zeros |= bit;
+		else break_terms_ref(&breakpoint.terms, t)->ones |= bit;
+		size_t w = 0;
+		while(w < word_masks_count(&breakpoint.triggers) && word_masks_ref(&breakpoint.triggers, w)->word != word) w++;
+		if(w == word_masks_count(&breakpoint.triggers)) word_masks_push(&breakpoint.triggers, (word_mask_t){word, 0});
+		word_masks_ref(&breakpoint.triggers, w)->mask |= bit;
+	}
+	if(expect_term || *cursor != 0){
+		printf("Error: Breakpoint %s: expected a wire after '&' or '|' and nothing else\n", expression);
+		hda_deinit(&breakpoint.terms);
+		hda_deinit(&breakpoint.triggers);
+		return -1;
+	}
+	breakpoint.was_true = eval_breakpoint(widget, &breakpoint);
+	breakpoints_push(&widget->breakpoints, breakpoint);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static bool eval_breakpoint(bit_widget_t* widget, breakpoint_t* breakpoint){
+	size_t count = break_terms_count(&breakpoint->terms);
+	for(size_t t = 0; t < count;){
+		uint32_t clause = break_terms_ref(&breakpoint->terms, t)->clause;
+		bool holds = true;
+		for(; t < count && break_terms_ref(&breakpoint->terms, t)->clause == clause; t++){
+			break_term_t* term = break_terms_ref(&breakpoint->terms, t);
+			uint64_t word = widget->state.data[term->word];
+			holds &= (word & term->ones) == term->ones && (word & term->zeros) == 0;
+		}
+		if(holds) return true;
+	}
+	return false;
+}
+//-----------------------------------------------------------------------------
+// Evaluates only the breakpoints whose wires changed in the last step.
+// Returns if one turned true, the first of them is kept in break_hit.
+static bool check_breakpoints(bit_widget_t* widget){
+	for(size_t i = 0; i < breakpoints_count(&widget->breakpoints); i++){
+		breakpoint_t* breakpoint = breakpoints_ref(&widget->breakpoints, i);
+		bool touched = false;
+		for(size_t w = 0; w < word_masks_count(&breakpoint->triggers) && !touched; w++){
+			word_mask_t* trigger = word_masks_ref(&breakpoint->triggers, w);
+			touched = (widget->changed.data[trigger->word] & trigger->mask) != 0;
+		}
+		if(!touched) continue;
+		bool now_true = eval_breakpoint(widget, breakpoint);
+		if(now_true && !breakpoint->was_true && widget->break_hit == (size_t)-1) widget->break_hit = i;
+		breakpoint->was_true = now_true;
+	}
+	return widget->break_hit != (size_t)-1;
+}
+//-----------------------------------------------------------------------------
+// Prints the breakpoint that fired and the state of every pin
+void bitwid_report_break(bit_widget_t* widget){
+	breakpoint_t* breakpoint = breakpoints_ref(&widget->breakpoints, widget->break_hit);
+	printf("[BITWIDGETS] Break at tick %llu: %s\n", (unsigned long long)widget->tick, breakpoint->expression);
+	if(!pins_count(&widget->pins)) return;
+	for(size_t p = 0; p < pins_count(&widget->pins); p++){
+		printf("%s%s=%d", p ? " " : "", pins_ref(&widget->pins, p)->name, bitwid_get_pin(widget, p));
+	}
+	printf("\n");
+}
+//-----------------------------------------------------------------------------
+// FNV-1a step over size bytes
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size){
+	const uint8_t* bytes = data;
+	for(size_t i = 0; i < size; i++){
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+//-----------------------------------------------------------------------------
+// Hash of the wire count, the gates and which wires are inputs
+static uint64_t get_netlist_hash(bit_widget_t* widget){
+	uint64_t counts[2] = {wires_count(&widget->wires), gates_count(&widget->gates)};
+	uint64_t hash = hash_bytes(1469598103934665603ULL, counts, sizeof(counts));
+	for(size_t i = 0; i < gates_count(&widget->gates); i++){
+		gate_t* gate = gates_ref(&widget->gates, i);
+		uint64_t values[3] = {gate->type, gate->input_wire_id, gate->output_wire_id};
+		hash = hash_bytes(hash, values, sizeof(values));
+	}
+	return hash_bytes(hash, widget->touchable.data, widget->touchable.words * sizeof(uint64_t));
+}
+//-----------------------------------------------------------------------------
+// Writes the header, the wire states as packed words and the stimulus events
+// not applied yet
+int bitwid_save_state(bit_widget_t* widget, char* filename){
+	FILE* file = fopen(filename, "wb");
+	if(!file){
+		printf("Error: Could not open state file %s\n", filename);
+		return -1;
+	}
+	size_t pending = events_count(&widget->stimulus) - widget->stimulus_cursor;
+	state_header_t header = {BITWID_STATE_MAGIC, get_netlist_hash(widget), widget->tick, 
+							 widget->state.bits, pending};
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(widget->state.data, sizeof(uint64_t), widget->state.words, file);
+	for(size_t i = widget->stimulus_cursor; i < events_count(&widget->stimulus); i++){
+		stimulus_event_t* event = events_ref(&widget->stimulus, i);
+		state_event_t record = {event->tick, event->wire_id, event->line, event->value, {0}};
+		fwrite(&record, sizeof(record), 1, file);
+	}
+	int failed = ferror(file);
+	if(fclose(file) != 0 || failed){
+		printf("Error: Could not write state file %s\n", filename);
+		return -1;
+	}
+	printf("[BITWIDGETS] Saved state of tick %llu to %s\n", (unsigned long long)widget->tick, filename);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Restores a state saved from the same circuit. The file size is checked
+// first so the wire states can be read straight into the state bitset.
+// Replaces the stimulus events loaded before.
+int bitwid_load_state(bit_widget_t* widget, char* filename){
+	FILE* file = fopen(filename, "rb");
+	if(!file){
+		printf("Error: Could not open state file %s\n", filename);
+		return -1;
+	}
+	state_header_t header;
+	if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, BITWID_STATE_MAGIC, 8) != 0){
+		printf("Error: %s is not a state file\n", filename);
+		fclose(file);
+		return -1;
+	}
+	if(header.netlist_hash != get_netlist_hash(widget) || header.wire_count != widget->state.bits){
+		printf("Error: %s was saved from another circuit\n", filename);
+		fclose(file);
+		return -1;
+	}
+	size_t state_size = widget->state.words * sizeof(uint64_t);
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, sizeof(header), SEEK_SET);
+	if(file_size < 0 || (uint64_t)file_size != sizeof(header) + state_size + header.event_count * sizeof(state_event_t)){
+		printf("Error: %s has the wrong size\n", filename);
+		fclose(file);
+		return -1;
+	}
+	bool complete = fread(widget->state.data, 1, state_size, file) == state_size;
+	hda_clear(&widget->stimulus);
+	for(uint64_t i = 0; i < header.event_count && complete; i++){
+		state_event_t record;
+		complete = fread(&record, sizeof(record), 1, file) == 1 && record.wire_id < widget->state.bits;
+		if(complete) events_push(&widget->stimulus, (stimulus_event_t){record.tick, record.wire_id, record.line, record.value != 0});
+	}
+	fclose(file);
+	hbs_copy(&widget->last_state, &widget->state);
+	hbs_clear_all(&widget->changed);
+	widget->tick = header.tick;
+	widget->stimulus_cursor = 0;
+	if(!complete){
+		printf("Error: Could not read state file %s\n", filename);
+		return -1;
+	}
+	printf("[BITWIDGETS] Loaded state of tick %llu from %s\n", (unsigned long long)widget->tick, filename);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Starts keeping history from the current tick, sealed chunks past budget
+// bytes are dropped oldest first
+void bitwid_enable_history(bit_widget_t* widget, size_t budget){
+	history_t* history = calloc(1, sizeof(history_t));
+	hdq_init(&history->chunks, sizeof(record_chunk_t*));
+	history->chunk = new_record_chunk(&widget->state, widget->tick);
+	history->budget = budget;
+	hbs_init(&history->view, widget->state.bits);
+	hda_init(&history->ids, sizeof(uint8_t));
+	widget->history = history;
+}
+//-----------------------------------------------------------------------------
+void bitwid_disable_history(bit_widget_t* widget){
+	history_t* history = widget->history;
+	while(hdq_get_item_fill(&history->chunks)){
+		record_chunk_t* chunk;
+		hdq_pop_front(&history->chunks, &chunk);
+		free_record_chunk(chunk);
+	}
+	hdq_deinit(&history->chunks);
+	free_record_chunk(history->chunk);
+	hbs_deinit(&history->view);
+	hda_deinit(&history->ids);
+	free(history);
+	widget->history = 0;
+}
+//-----------------------------------------------------------------------------
+// Called by bitwid_simulate after every step
+static void history_append(bit_widget_t* widget){
+	history_t* history = widget->history;
+	append_record_changes(history->chunk, widget->tick, &widget->changed, &history->ids);
+	size_t keyframe_size = widget->state.words * sizeof(uint64_t);
+	size_t chunk_size = hda_get_item_fill(&history->chunk->bytes);
+	if(chunk_size < keyframe_size || chunk_size < 256) return;
+	// Changes outgrew the keyframe, start the next one
+	hdq_push_back(&history->chunks, &history->chunk);
+	history->bytes += keyframe_size + chunk_size;
+	history->chunk = new_record_chunk(&widget->state, widget->tick);
+	while(history->bytes > history->budget && hdq_get_item_fill(&history->chunks)){
+		record_chunk_t* oldest;
+		hdq_pop_front(&history->chunks, &oldest);
+		history->bytes -= keyframe_size + hda_get_item_fill(&oldest->bytes);
+		free_record_chunk(oldest);
+	}
+}
+//-----------------------------------------------------------------------------
+// Shows the state of an earlier tick from its keyframe and the changes
+// after it. Viewing the current tick goes back to the live state. Returns
+// false if the tick is not kept.
+bool bitwid_view_tick(bit_widget_t* widget, uint64_t tick){
+	history_t* history = widget->history;
+	if(!history || tick > widget->tick) return false;
+	if(tick == widget->tick){
+		history->viewing = false;
+		return true;
+	}
+	record_chunk_t* chunk = history->chunk;
+	for(size_t i = hdq_get_item_fill(&history->chunks); chunk->start_tick > tick; i--){
+		if(i == 0) return false;
+		chunk = *(record_chunk_t**)hdq_get_reference(&history->chunks, i - 1);
+	}
+	replay_record_chunk(chunk, tick, history->view.data);
+	history->view_tick = tick;
+	history->viewing = true;
+	return true;
+}
+//-----------------------------------------------------------------------------
+// Writes the circuit as an image that loads back with the current wire
+// states, HIGH wires in their color and LOW ones in lower_color. Only the
+// wire pixels are written, straight into a RGBA copy of the image.
+int bitwid_export_image(bit_widget_t* widget, char* filename){
+	Image image = ImageCopy(widget->image);
+	ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+	Color* colors = image.data;
+	for(size_t i = 0; i < wires_count(&widget->wires); i++){
+		wire_t* wire = wires_ref(&widget->wires, i);
+		Color color = GetColor(wire->color);
+		if(!hbs_test(&widget->state, i)) color = lower_color(color);
+		pixel_t* pixels = hda_to_contiguous(&wire->pixels);
+		for(size_t p = 0; p < pixels_count(&wire->pixels); p++){
+			colors[pixels[p].y * image.width + pixels[p].x] = color;
+		}
+	}
+	bool exported = ExportImage(image, filename);
+	UnloadImage(image);
+	if(!exported){
+		printf("Error: Could not write image %s\n", filename);
+		return -1;
+	}
+	printf("[BITWIDGETS] Exported state of tick %llu to %s\n", (unsigned long long)widget->tick, filename);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Watches the image for changes, 0 where there is no inotify
+loader_t* loader_start(char* filename, char* pin_filename){
+	#ifdef __linux__
+	int notify = inotify_init1(IN_CLOEXEC);
+	if(notify < 0) return 0;
+	// Editors often write a new file and rename it over the old one, so the
+	// directory is watched rather than the file
+	char* directory = strdup(filename);
+	char* slash = strrchr(directory, '/');
+	if(slash) slash[slash == directory] = 0;
+	if(inotify_add_watch(notify, slash ? directory : ".", IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+		printf("Error: Could not watch %s for changes\n", filename);
+		free(directory);
+		close(notify);
+		return 0;
+	}
+	free(directory);
+	loader_t* loader = calloc(1, sizeof(loader_t));
+	loader->filename = strdup(filename);
+	loader->pin_filename = pin_filename ? strdup(pin_filename) : 0;
+	loader->notify = notify;
+	pthread_mutex_init(&loader->lock, 0);
+	if(pthread_create(&loader->thread, 0, loader_worker, loader) != 0){
+		printf("Error: Could not start watching %s for changes\n", filename);
+		pthread_mutex_destroy(&loader->lock);
+		close(notify);
+		free(loader->filename);
+		free(loader->pin_filename);
+		free(loader);
+		return 0;
+	}
+	return loader;
+	#else
+	(void)filename;
+	(void)pin_filename;
+	return 0;
+	#endif
+}
+//-----------------------------------------------------------------------------
+void loader_stop(loader_t* loader){
+	if(!loader) return;
+	pthread_mutex_lock(&loader->lock);
+	loader->stop = 1;
+	pthread_mutex_unlock(&loader->lock);
+	pthread_join(loader->thread, 0);
+	if(loader->ready){
+		bitwid_deinit(loader->ready);
+		free(loader->ready);
+	}
+	close(loader->notify);
+	pthread_mutex_destroy(&loader->lock);
+	free(loader->filename);
+	free(loader->pin_filename);
+	free(loader);
+}
+//-----------------------------------------------------------------------------
+// The widget built since the last call, 0 if none
+bit_widget_t* loader_take(loader_t* loader){
+	if(!loader) return 0;
+	pthread_mutex_lock(&loader->lock);
+	bit_widget_t* widget = loader->ready;
+	loader->ready = 0;
+	pthread_mutex_unlock(&loader->lock);
+	return widget;
+}
+//-----------------------------------------------------------------------------
+// Loads the image once it is left alone for BITWID_RELOAD_SETTLE_MS, a newer
+// build replaces one the window has not taken yet
+static void* loader_worker(void* arg){
+	#ifdef __linux__
+	loader_t* loader = arg;
+	char* name = strrchr(loader->filename, '/');
+	name = name ? name + 1 : loader->filename;
+	char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	bool changed = false;
+	while(1){
+		pthread_mutex_lock(&loader->lock);
+		bool stop = loader->stop;
+		pthread_mutex_unlock(&loader->lock);
+		if(stop) break;
+		// Also wakes up regularly to see stop
+		struct pollfd poller = {loader->notify, POLLIN, 0};
+		if(poll(&poller, 1, BITWID_RELOAD_SETTLE_MS) > 0){
+			ssize_t length = read(loader->notify, events, sizeof(events));
+			struct inotify_event* event;
+			for(char* cursor = events; cursor < events + length; cursor += sizeof(struct inotify_event) + event->len){
+				event = (struct inotify_event*)cursor;
+				if(event->len && strcmp(event->name, name) == 0) changed = true;
+			}
+			continue;
+		}
+		if(!changed) continue;
+		changed = false;
+		bit_widget_t* widget = malloc(sizeof(bit_widget_t));
+		bitwid_init(widget, loader->filename);
+		if(!widget->image.data){
+			printf("Error: Could not reload %s\n", loader->filename);
+			bitwid_deinit(widget);
+			free(widget);
+			continue;
+		}
+		// Pins that fail to load are reported, the carry over drops what needed them
+		if(loader->pin_filename) bitwid_load_pins(widget, loader->pin_filename);
+		pthread_mutex_lock(&loader->lock);
+		bit_widget_t* stale = loader->ready;
+		loader->ready = widget;
+		pthread_mutex_unlock(&loader->lock);
+		if(stale){
+			bitwid_deinit(stale);
+			free(stale);
+		}
+	}
+	#else
+	(void)arg;
+	#endif
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Takes over the tick, wire states and debugging setup of a widget loaded
+// from an older version of the image. Wires are matched through the pixels
+// they share in the wire planes, new wires keep the state drawn for them.
+// Pending stimulus, probes and breakpoints follow the matched wires, watches
+// go by pin name. A running recording ends with the old widget.
+void bitwid_carry_over(bit_widget_t* widget, bit_widget_t* old){
+	size_t old_count = wires_count(&old->wires);
+	uint32_t* wire_map = malloc((old_count ? old_count : 1) * sizeof(uint32_t)); // New id of every old wire
+	memset(wire_map, 0xFF, (old_count ? old_count : 1) * sizeof(uint32_t));
+	hh_bitset_t matched; hbs_init(&matched, widget->state.bits);
+	size_t width = widget->image.width < old->image.width ? widget->image.width : old->image.width;
+	size_t height = widget->image.height < old->image.height ? widget->image.height : old->image.height;
+	for(size_t y = 0; y < height; y++){
+		uint32_t* new_row = widget->wire_plane + y * widget->image.width;
+		uint32_t* old_row = old->wire_plane + y * old->image.width;
+		for(size_t x = 0; x < width; x++){
+			if(new_row[x] == NO_WIRE || old_row[x] == NO_WIRE) continue;
+			if(wire_map[old_row[x]] == NO_WIRE) wire_map[old_row[x]] = new_row[x];
+			if(hbs_test(&matched, new_row[x])) continue;
+			hbs_set(&matched, new_row[x]);
+			hbs_assign(&widget->state, new_row[x], hbs_test(&old->state, old_row[x]));
+		}
+	}
+	hbs_deinit(&matched);
+	hbs_copy(&widget->last_state, &widget->state);
+	widget->tick = old->tick;
+	widget->probe_span = old->probe_span;
+	#ifdef BITWID_ACTIVITY
+	widget->show_heatmap = old->show_heatmap;
+	#endif
+	size_t dropped = 0;
+	for(size_t i = old->stimulus_cursor; i < events_count(&old->stimulus); i++){
+		stimulus_event_t event = events_get(&old->stimulus, i);
+		if(wire_map[event.wire_id] == NO_WIRE){
+			dropped++;
+			continue;
+		}
+		event.wire_id = wire_map[event.wire_id];
+		events_push(&widget->stimulus, event);
+	}
+	if(dropped) printf("[BITWIDGETS] Dropped %zu stimulus events of wires gone with the reload\n", dropped);
+	dropped = 0;
+	for(size_t i = 0; i < probes_count(&old->probes); i++){
+		uint32_t wire_id = wire_map[probes_ref(&old->probes, i)->wire_id];
+		if(wire_id == NO_WIRE) dropped++;
+		// Two old wires may have become one, toggling it twice keeps it
+		else if(!bitwid_toggle_probe(widget, wire_id)) bitwid_toggle_probe(widget, wire_id);
+	}
+	if(dropped) printf("[BITWIDGETS] Dropped %zu probes of wires gone with the reload\n", dropped);
+	for(size_t i = 0; i < hda_get_item_fill(&old->watches); i++){
+		char* name = pins_ref(&old->pins, pin_ids_get(&old->watches, i))->name;
+		size_t pin = bitwid_find_pin(widget, name);
+		if(pin != (size_t)-1) bitwid_watch_pin(widget, pin);
+		else printf("[BITWIDGETS] Dropped the watch on %s, the pin is gone with the reload\n", name);
+	}
+	// A run paused at a breakpoint stays paused if the breakpoint is kept
+	widget->break_hit = -1;
+	for(size_t i = 0; i < breakpoints_count(&old->breakpoints); i++){
+		char* expression = breakpoints_ref(&old->breakpoints, i)->expression;
+		size_t index = breakpoints_count(&widget->breakpoints);
+		if(bitwid_add_breakpoint(widget, expression) != 0){
+			printf("[BITWIDGETS] Dropped the breakpoint %s with the reload\n", expression);
+			continue;
+		}
+		if(i == old->break_hit) widget->break_hit = index;
+	}
+	if(old->break_hit != (size_t)-1 && widget->break_hit == (size_t)-1){
+		printf("[BITWIDGETS] The run goes on, its breakpoint is gone with the reload\n");
+	}
+	if(old->recorder) printf("[BITWIDGETS] Recording ends with the reload\n");
+	free(wire_map);
+}
+//-----------------------------------------------------------------------------
+// Paints a pixel of the image and updates the netlist around it instead of
+// extracting everything again. A pixel links to others at most
+// BITWID_EDIT_REACH away, through crossings and gates, so only wires with a
+// pixel that close can join or split. Only their pixels are flooded again,
+// gates next to the pixel are looked for again, and the gates on changed
+// wires are attached again.
+// A wire keeps its id, and with it its pins and probes, for the part
+// holding its first pixel left. Joined wires are HIGH if any part was, new
+// ones start LOW. Wires that vanish stay empty until a new wire takes their
+// id. History restarts and a recording ends, as the wire ids change.
+int bitwid_edit_pixel(bit_widget_t* widget, size_t x, size_t y, Color color){
+	Image* img = &widget->image;
+	if(x >= (unsigned int)img->width || y >= (unsigned int)img->height) return -1;
+	if(ColorToInt(GetImageColor(*img, x, y)) == ColorToInt(color)) return 0;
+	if(widget->recorder){
+		printf("[BITWIDGETS] Recording ends with the edit\n");
+		recorder_stop(widget);
+	}
+	size_t history_budget = widget->history ? widget->history->budget : 0;
+	if(widget->history) bitwid_disable_history(widget);
+	size_t old_count = wires_count(&widget->wires);
+	size_t x0 = x > BITWID_EDIT_REACH ? x - BITWID_EDIT_REACH : 0;
+	size_t y0 = y > BITWID_EDIT_REACH ? y - BITWID_EDIT_REACH : 0;
+	size_t x1 = x + BITWID_EDIT_REACH < (unsigned int)img->width ? x + BITWID_EDIT_REACH : (unsigned int)img->width - 1;
+	size_t y1 = y + BITWID_EDIT_REACH < (unsigned int)img->height ? y + BITWID_EDIT_REACH : (unsigned int)img->height - 1;
+	hh_bitset_t affected; hbs_init(&affected, old_count);
+	for(size_t py = y0; py <= y1; py++){
+		for(size_t px = x0; px <= x1; px++){
+			uint32_t wire_id = widget->wire_plane[py * img->width + px];
+			if(wire_id != NO_WIRE) hbs_set(&affected, wire_id);
+		}
+	}
+	ImageDrawPixel(img, x, y, color);
+	// Gates with their input on the pixel or next to it
+	for(size_t i = gates_count(&widget->gates); i-- > 0;){
+		gate_t* gate = gates_ref(&widget->gates, i);
+		if((gate->x > x ? gate->x - x : x - gate->x) + (gate->y > y ? gate->y - y : y - gate->y) > 1) continue;
+		*gate = gates_get(&widget->gates, gates_count(&widget->gates) - 1);
+		hda_popend(&widget->gates, 0);
+	}
+	find_gates_at(*img, x, y, &widget->gates);
+	for(int d = 0; d < 4; d++) find_gates_at(*img, x + direction_x[d], y + direction_y[d], &widget->gates);
+	// Gate pixels are at most one pixel past those inputs
+	for(size_t py = y > 2 ? y - 2 : 0; py <= y + 2; py++){
+		for(size_t px = x > 2 ? x - 2 : 0; px <= x + 2; px++) hbm_clear(&widget->gate_map, px, py);
+	}
+	for(size_t i = 0; i < gates_count(&widget->gates); i++){
+		gate_t* gate = gates_ref(&widget->gates, i);
+		if(gate->x + 3 >= x && gate->x <= x + 3 && gate->y + 3 >= y && gate->y <= y + 3) mark_gate(widget, gate);
+	}
+	// Take the affected wires apart
+	hh_darray_t old_pixels; wire_pixels_init(&old_pixels);
+	for(size_t id = hbs_find_next_set(&affected, 0); id != (size_t)-1; id = hbs_find_next_set(&affected, id + 1)){
+		wire_t* wire = wires_ref(&widget->wires, id);
+		for(size_t p = 0; p < pixels_count(&wire->pixels); p++){
+			pixel_t pix = pixels_get(&wire->pixels, p);
+			wire_pixels_push(&old_pixels, (wire_pixel_t){pix, id});
+			widget->wire_plane[pix.y * img->width + pix.x] = NO_WIRE;
+		}
+		// Refilled on the heap, as the arena can only grow its newest array in place
+		if(wire->pixels.allocator){
+			hda_deinit(&wire->pixels);
+			pixels_init(&wire->pixels);
+			#ifdef HH_DARRAY_STATS
+			hda_set_stats(&wire->pixels, &widget->pixel_stats);
+			#endif
+		}
+		else hda_clear(&wire->pixels);
+	}
+	hh_bitmap_t visited; hbm_init(&visited, img->width, img->height);
+	memcpy(visited.data, widget->gate_map.data, visited.stride * visited.height * sizeof(uint64_t));
+	for(size_t i = 0; i < wire_pixels_count(&old_pixels); i++){
+		wire_pixel_t* old = wire_pixels_ref(&old_pixels, i);
+		if(pixels_count(&wires_ref(&widget->wires, old->wire_id)->pixels)) continue;
+		wire_color_e wire_color = get_unvisited_wire_color(widget, &visited, old->pixel.x, old->pixel.y);
+		if(wire_color == SPACE || wire_color == WIRE_CROSSING) continue;
+		flood_wire(widget, &visited, old->pixel.x, old->pixel.y, old->wire_id);
+	}
+	// Whatever is left is a new wire, the painted pixel or a split off part
+	size_t next_id = 0;
+	size_t window = (x1 - x0 + 1) * (y1 - y0 + 1);
+	for(size_t i = 0; i < window + wire_pixels_count(&old_pixels); i++){
+		pixel_t pix = i < window ? (pixel_t){x0 + i % (x1 - x0 + 1), y0 + i / (x1 - x0 + 1)}
+								 : wire_pixels_get(&old_pixels, i - window).pixel;
+		wire_color_e wire_color = get_unvisited_wire_color(widget, &visited, pix.x, pix.y);
+		if(wire_color == SPACE || wire_color == WIRE_CROSSING) continue;
+		flood_wire(widget, &visited, pix.x, pix.y, claim_wire_id(widget, &affected, &next_id));
+	}
+	hbm_deinit(&visited);
+	// Crossings can only come or go near the pixel
+	for(size_t py = y0; py <= y1; py++){
+		for(size_t px = x0; px <= x1; px++){
+			bool linked = false;
+			for(int d = 0; d < 4; d++) linked |= get_wire_from_pixel(widget, px + direction_x[d], py + direction_y[d]) != (size_t)-1;
+			if(linked && !hbm_test(&widget->gate_map, px, py) && get_wire_color(GetImageColor(*img, px, py)) == WIRE_CROSSING) add_crossing(widget, px, py);
+			else if(hbm_test(&widget->crossing_map, px, py)) remove_crossing(widget, px, py);
+		}
+	}
+	size_t wire_count = wires_count(&widget->wires);
+	if(wire_count > old_count) resize_wire_states(widget, wire_count);
+	// States of the changed wires
+	hh_bitset_t changed; hbs_init(&changed, wire_count);
+	hh_bitset_t high; hbs_init(&high, wire_count);
+	for(size_t id = hbs_find_next_set(&affected, 0); id != (size_t)-1; id = hbs_find_next_set(&affected, id + 1)){
+		hbs_set(&changed, id);
+	}
+	for(size_t id = old_count; id < wire_count; id++) hbs_set(&changed, id);
+	for(size_t i = 0; i < wire_pixels_count(&old_pixels); i++){
+		wire_pixel_t* old = wire_pixels_ref(&old_pixels, i);
+		uint32_t wire_id = widget->wire_plane[old->pixel.y * img->width + old->pixel.x];
+		if(wire_id != NO_WIRE && hbs_test(&widget->state, old->wire_id)) hbs_set(&high, wire_id);
+	}
+	for(size_t id = hbs_find_next_set(&changed, 0); id != (size_t)-1; id = hbs_find_next_set(&changed, id + 1)){
+		hbs_assign(&widget->state, id, hbs_test(&high, id));
+		hbs_assign(&widget->last_state, id, hbs_test(&high, id));
+		hbs_set(&widget->touchable, id);
+	}
+	// Gates near the pixel or on a changed wire
+	for(size_t i = 0; i < gates_count(&widget->gates); i++){
+		gate_t* gate = gates_ref(&widget->gates, i);
+		bool near = gate->x + BITWID_EDIT_REACH + 2 >= x && gate->x <= x + BITWID_EDIT_REACH + 2 && 
+					gate->y + BITWID_EDIT_REACH + 2 >= y && gate->y <= y + BITWID_EDIT_REACH + 2;
+		if(!near && !hbs_test(&changed, gate->input_wire_id) && !hbs_test(&changed, gate->output_wire_id)) continue;
+		gate->input_wire_id = 0;
+		gate->output_wire_id = 0;
+		attach_gate(widget, gate);
+	}
+	hda_deinit(&old_pixels);
+	hbs_deinit(&affected);
+	hbs_deinit(&changed);
+	hbs_deinit(&high);
+	if(history_budget) bitwid_enable_history(widget, history_budget);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Id for a new wire, an empty one counted as affected or else a new one
+static size_t claim_wire_id(bit_widget_t* widget, hh_bitset_t* affected, size_t* next){
+	for(; *next < affected->bits; (*next)++){
+		if(pixels_count(&wires_ref(&widget->wires, *next)->pixels)) continue;
+		hbs_set(affected, *next);
+		return (*next)++;
+	}
+	wires_push(&widget->wires, (wire_t){0});
+	pixels_init(&wires_end(&widget->wires)->pixels);
+	#ifdef HH_DARRAY_STATS
+	hda_set_stats(&wires_end(&widget->wires)->pixels, &widget->pixel_stats);
+	#endif
+	return wires_count(&widget->wires) - 1;
+}
+//-----------------------------------------------------------------------------
+// Grows every per wire array for wires added by an edit
+static void resize_wire_states(bit_widget_t* widget, size_t wire_count){
+	size_t old_count = widget->state.bits;
+	size_t old_words = widget->state.words;
+	hbs_resize(&widget->state, wire_count);
+	hbs_resize(&widget->last_state, wire_count);
+	hbs_resize(&widget->changed, wire_count);
+	hbs_resize(&widget->touchable, wire_count);
+	hbs_resize(&widget->drive, wire_count);
+	#ifdef BITWID_ACTIVITY
+	size_t words = widget->state.words;
+	widget->activity = realloc(widget->activity, wire_count * sizeof(uint64_t));
+	memset(widget->activity + old_count, 0, (wire_count - old_count) * sizeof(uint64_t));
+	widget->activity_planes = realloc(widget->activity_planes, words * BITWID_ACTIVITY_PLANES * sizeof(uint64_t));
+	memset(widget->activity_planes + old_words * BITWID_ACTIVITY_PLANES, 0, (words - old_words) * BITWID_ACTIVITY_PLANES * sizeof(uint64_t));
+	#else
+	(void)old_count;
+	(void)old_words;
+	#endif
+}
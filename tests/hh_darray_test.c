@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+// Checks hh_darray in its default chained mode against a plain array model
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+
+#define HH_DARRAY_SHORT_PREFIX
+#define HH_DARRAY_IMPLEMENTATION
+#include "hh_darray.h"
+
+#define MODEL_SIZE 4096
+
+static int failures = 0;
+
+#define CHECK(cond) do{ \
+	if(!(cond)){ \
+		printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+		failures++; \
+	} \
+}while(0)
+
+//-----------------------------------------------------------------------------
+static void check_items(hh_darray_t* array, uint32_t* model, size_t count){
+	CHECK(hh_darray_get_item_fill(array) == count);
+	for(size_t i = 0; i < count; i++){
+		uint32_t* item = hh_darray_get_reference(array, i);
+		CHECK(item && *item == model[i]);
+	}
+}
+//-----------------------------------------------------------------------------
+// Reserve more than fits, append a few and take them back off
+static void test_reserve_popend(void){
+	hh_darray_t array; hh_darray_init(&array, sizeof(uint32_t));
+	hh_darray_reserve(&array, 100);
+	for(uint32_t i = 0; i < 5; i++) hh_darray_append(&array, &i);
+	for(uint32_t i = 5; i-- > 0;){
+		uint32_t item = -1;
+		hh_darray_popend(&array, &item);
+		CHECK(item == i);
+	}
+	CHECK(hh_darray_get_item_fill(&array) == 0);
+	hh_darray_deinit(&array);
+}
+//-----------------------------------------------------------------------------
+// Reserve after the array has already chained segments, then clear
+static void test_reserve_clear(void){
+	uint32_t model[MODEL_SIZE];
+	hh_darray_t array; hh_darray_init(&array, sizeof(uint32_t));
+	size_t count = 0;
+	for(; count < 50; count++){
+		model[count] = count * 7;
+		hh_darray_append(&array, &model[count]);
+	}
+	hh_darray_reserve(&array, 1000);
+	for(; count < 60; count++){
+		model[count] = count * 7;
+		hh_darray_append(&array, &model[count]);
+	}
+	check_items(&array, model, count);
+	hh_darray_clear(&array);
+	CHECK(hh_darray_get_item_fill(&array) == 0);
+	uint32_t item = 3;
+	hh_darray_append(&array, &item);
+	check_items(&array, &item, 1);
+	hh_darray_deinit(&array);
+}
+//-----------------------------------------------------------------------------
+// Random mix of every growing and shrinking call
+static void test_random(void){
+	uint32_t model[MODEL_SIZE];
+	hh_darray_t array; hh_darray_init(&array, sizeof(uint32_t));
+	size_t count = 0;
+	uint64_t seed = 1;
+	for(int step = 0; step < 20000; step++){
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		uint32_t value = seed >> 33;
+		switch((seed >> 20) % 6){
+			case 0:
+			case 1:
+				if(count == MODEL_SIZE) break;
+				model[count++] = value;
+				hh_darray_append(&array, &value);
+				break;
+			case 2:{
+				size_t n = value % 40;
+				if(count + n > MODEL_SIZE) break;
+				for(size_t i = 0; i < n; i++) model[count + i] = value + i;
+				hh_darray_append_n(&array, &model[count], n);
+				count += n;
+				break;
+			}
+			case 3:
+				hh_darray_reserve(&array, count + value % 300);
+				break;
+			case 4:
+				if(!count) break;
+				uint32_t item;
+				hh_darray_popend(&array, &item);
+				CHECK(item == model[--count]);
+				break;
+			case 5:
+				if(value % 50) break;
+				hh_darray_clear(&array);
+				count = 0;
+				break;
+		}
+		if(step % 97 == 0) check_items(&array, model, count);
+	}
+	check_items(&array, model, count);
+	hh_darray_deinit(&array);
+}
+//-----------------------------------------------------------------------------
+int main(void){
+	test_reserve_popend();
+	test_reserve_clear();
+	test_random();
+	if(failures){
+		printf("hh_darray: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("hh_darray: ok\n");
+	return 0;
+}